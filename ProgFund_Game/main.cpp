@@ -3,17 +3,27 @@
 #include "source/Engine/ResourceManager.hpp"
 #include "source/Engine/Window.hpp"
 #include "source/Engine/Scene.hpp"
+#include "source/Engine/JobSystem.hpp"
+#include "source/Engine/Profiler.hpp"
+#include "source/Engine/FrameStats.hpp"
+#include "source/Engine/FixedTimestep.hpp"
+#include "source/Engine/FramePacer.hpp"
 #include "source/Engine/Object.hpp"
+#include "source/Engine/ObjectManager.hpp"
+#include "source/Engine/RenderPipeline.hpp"
+#include "source/Engine/Replay.hpp"
 
-DWORD DxGetTime();
+#include "source/Game/ShotData.hpp"
 
 class Circle : public TaskBase {
 public:
 	Sprite2D sprite;
 	double angle;
+	double anglePrev;
 
 	Circle(Scene* parent, D3DXVECTOR2 position) : TaskBase(parent) {
 		angle = 0;
+		anglePrev = 0;
 
 		ResourceManager* resourceManager = ResourceManager::GetBase();
 		auto textureCircle = resourceManager->LoadResource<TextureResource>("eff_magiccircle.png", "eff_magiccircle.png");
@@ -27,14 +37,62 @@ public:
 	}
 
 	virtual void Render() {
-		sprite.SetAngleZ(angle);
+		double alpha = GetParent()->GetInterpolation();
+		sprite.SetAngleZ(anglePrev + (angle - anglePrev) * alpha);
 		sprite.Render();
 	}
+	virtual void Extract(RenderFrame* frame) {
+		double alpha = frame->GetInterpolation();
+		sprite.SetAngleZ(anglePrev + (angle - anglePrev) * alpha);
+		frame->AddObject(&sprite);
+	}
 	virtual void Update() {
+		anglePrev = angle;
 		angle += 0.01;
 	}
+
+	virtual void Serialize(SnapshotWriter* writer) {
+		writer->Write(angle);
+		writer->Write(anglePrev);
+		sprite.Serialize(writer);
+	}
+	virtual void Restore(SnapshotReader* reader) {
+		reader->Read(angle);
+		reader->Read(anglePrev);
+		sprite.Restore(reader);
+	}
 };
 
+static InputState PollInput(HWND hWnd) {
+	InputState input = { 0U };
+	if (GetForegroundWindow() != hWnd) return input;
+
+	auto IsDown = [](int key) { return (GetAsyncKeyState(key) & 0x8000) != 0; };
+	input.SetHeld(VirtualKey::Left, IsDown(VK_LEFT));
+	input.SetHeld(VirtualKey::Right, IsDown(VK_RIGHT));
+	input.SetHeld(VirtualKey::Up, IsDown(VK_UP));
+	input.SetHeld(VirtualKey::Down, IsDown(VK_DOWN));
+	input.SetHeld(VirtualKey::Shot, IsDown('Z'));
+	input.SetHeld(VirtualKey::Bomb, IsDown('X'));
+	input.SetHeld(VirtualKey::Slow, IsDown(VK_SHIFT));
+	input.SetHeld(VirtualKey::Pause, IsDown(VK_ESCAPE));
+	return input;
+}
+
+//Command line switches, case-insensitive:
+//	-record: saves the run's replay to replay.rpy on exit
+//	-stats: dumps frame times to frame_stats.csv every 600 frames
+static bool HasSwitch(LPCWSTR name) {
+	int argc = 0;
+	LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	if (argv == nullptr) return false;
+	bool res = false;
+	for (int i = 1; i < argc && !res; ++i)
+		res = _wcsicmp(argv[i], name) == 0;
+	LocalFree(argv);
+	return res;
+}
+
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow) {
 	HWND hWnd = nullptr;
 	try {
@@ -47,33 +105,73 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 		ResourceManager* resourceManager = new ResourceManager();
 		resourceManager->Initialize();
 
+		JobSystem* jobSystem = new JobSystem();
+		jobSystem->Initialize();
+
+		ShotDataTable* shotData = new ShotDataTable();
+		shotData->Load(PathProperty::GetWorkingDirectory() + "resource/data/shot_data.txt",
+			PathProperty::GetWorkingDirectory() + "resource/data/shot_data.cache");
+		printf("Loaded shot data, %u IDs%s.\n", (uint32_t)shotData->GetShotCount(),
+			shotData->IsCached() ? " from cache" : "");
+
 		printf("Initialized application.\n");
 
 		auto textureCircle = resourceManager->LoadResource<TextureResource>("eff_magiccircle.png", "eff_magiccircle.png");
 
 		Scene* scene = new Scene();
 
-		shared_ptr<Circle> circle1 = shared_ptr<Circle>(new Circle(scene, D3DXVECTOR2(320, 240)));
+		shared_ptr<Circle> circle1 = TaskBase::Create<Circle>(scene, D3DXVECTOR2(320, 240));
 		scene->AddTask(circle1);
 
-		shared_ptr<Circle> circle2 = shared_ptr<Circle>(new Circle(scene, D3DXVECTOR2(100, 140)));
+		shared_ptr<Circle> circle2 = TaskBase::Create<Circle>(scene, D3DXVECTOR2(100, 140));
 		scene->AddTask(circle2);
 
-		shared_ptr<Circle> circle3 = shared_ptr<Circle>(new Circle(scene, D3DXVECTOR2(420, 390)));
+		shared_ptr<Circle> circle3 = TaskBase::Create<Circle>(scene, D3DXVECTOR2(420, 390));
 		scene->AddTask(circle3);
 
+		//Objects outside the simulation, updated and drawn on this thread over the scene
+		ObjectManager* objectManager = new ObjectManager();
 		{
-			//Refresh rate -> 60fps
-			double t_target_ms = 1000.0 / 60;
-
-			DWORD current_time = DxGetTime();
-			DWORD previous_time = current_time;
-
-			DWORD accum_fps = 0;
-			DWORD accum_update = 0;
+			shared_ptr<Sprite2D> overlay = ObjectBase::Create<Sprite2D>();
+			overlay->SetTexture(textureCircle);
+			overlay->SetSourceRectNormalized(DxRect<float>(0, 0, 1, 1));
+			overlay->SetDestCenter();
+			overlay->UpdateVertexBuffer();
+			overlay->SetPosition(D3DXVECTOR2(600, 440));
+			overlay->SetScale(0.25f, 0.25f, 1.0f);
+			overlay->SetAlpha(128);
+			objectManager->AddObject(overlay);
+		}
 
-			std::list<DWORD> listDelta;
-			std::list<double> listFPS;
+		{
+			//Logic runs at exactly 60Hz, rendering is paced to the display and interpolates between updates
+			FixedTimestep timestep(60, 5);
+			UINT rateRender = winMain->GetRefreshRate();
+			if (rateRender == 0U) rateRender = 60U;
+			FramePacer pacer(rateRender);
+			printf("Rendering at %uHz.\n", (uint32_t)rateRender);
+
+			//The run is recorded as its seed and per-update inputs, only when asked for
+			uint64_t seed = (uint64_t)stdch::steady_clock::now().time_since_epoch().count();
+			scene->SetSeed(seed);
+			bool bRecord = HasSwitch(L"-record");
+			Replay replay;
+			replay.Reset(0U, seed);
+
+			//The scene is updated on its own thread, one frame ahead of what's drawn here
+			RenderPipeline pipeline;
+			pipeline.Initialize(scene);
+
+			FrameStats frameStats(600);
+			frameStats.SetBudget((uint64_t)timestep.GetStepTime());
+			if (HasSwitch(L"-stats"))
+				frameStats.SetDumpFile("frame_stats.csv", 600);
+
+			auto FrameTime = [](const stdch::steady_clock::time_point& from, const stdch::steady_clock::time_point& to) {
+				return (uint64_t)stdch::duration_cast<stdch::nanoseconds>(to - from).count();
+			};
+			stdch::steady_clock::time_point timePrevFrame = stdch::steady_clock::now();
+			stdch::steady_clock::time_point timePrevFPS = timePrevFrame;
 
 			MSG msg = { 0 };
 			while (msg.message != WM_QUIT) {
@@ -82,54 +180,66 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 					DispatchMessage(&msg);
 				}
 				else {
-					current_time = DxGetTime();
-					DWORD delta_time = current_time - previous_time;
-
-					accum_fps += delta_time;
-					accum_update += delta_time;
-
-					previous_time = current_time;
-
-					if (accum_update > t_target_ms) {
-						listDelta.push_back(accum_update);
-
-						//Engine render
-						winMain->BeginScene();
-						{
-							scene->Update();
-							scene->Render();
-						}
-						winMain->EndScene();
-
-						accum_update = 0;
-					}
-
-					//2 fps updates per second, hopefully
-					if (accum_fps > 500) {
-						DWORD sumMs = 0;
-						for (DWORD& iMs : listDelta)
-							sumMs += iMs;
-						listDelta.clear();
-
-						double fps = (t_target_ms * 1000) / (double)sumMs;
-						listFPS.push_back(fps);
-						if (listFPS.size() > 64)
-							listFPS.pop_front();
-						winMain->SetFPS(fps);
-
-						//fpsCounter.setString(StringFormat("%.2f fps", fps));
-						//printf("%.2f\n", fps);
-
-						accum_fps = 0;
+					PROFILE_ZONE("Frame");
+
+					FrameStats::Sample sample;
+					auto timeStart = stdch::steady_clock::now();
+					sample.time[(size_t)FrameStats::Channel::Interval] = FrameTime(timePrevFrame, timeStart);
+					timePrevFrame = timeStart;
+
+					size_t countUpdate = timestep.Advance(timeStart);
+					InputState input = PollInput(hWnd);
+					for (size_t i = 0; bRecord && i < countUpdate; ++i)
+						replay.AddFrame(input);
+					pipeline.Kick(countUpdate, (float)timestep.GetAlpha(), input);
+					for (size_t i = 0; i < countUpdate; ++i)
+						objectManager->UpdateObjects();
+					auto timeUpdate = stdch::steady_clock::now();
+
+					//Engine render
+					winMain->BeginScene();
+					pipeline.GetRenderFrame()->Render();
+					objectManager->RenderObjects();
+					auto timeRender = stdch::steady_clock::now();
+
+					winMain->EndScene();
+					auto timePresent = stdch::steady_clock::now();
+
+					sample.time[(size_t)FrameStats::Channel::Update] = pipeline.GetSimulationTime();
+					sample.time[(size_t)FrameStats::Channel::Render] = FrameTime(timeUpdate, timeRender);
+					sample.time[(size_t)FrameStats::Channel::Present] = FrameTime(timeRender, timePresent);
+					frameStats.Record(sample);
+
+					//2 fps updates per second
+					if (timePresent - timePrevFPS >= stdch::milliseconds(500)) {
+						winMain->SetFPS(frameStats.GetFPS(30));
+						timePrevFPS = timePresent;
 					}
 
-					Sleep(1);
+					pacer.Wait();
 				}
 			}
+			pipeline.Release();
+			if (bRecord) {
+				replay.Save("replay.rpy");
+				printf("Saved the replay, %u updates.\n", (uint32_t)replay.GetFrameCount());
+			}
+
+			FramePacer::Jitter jitter = pacer.GetJitter();
+			printf("Frame interval: %.3fms mean, %.3fms deviation, %.3fms max error over %u frames\n",
+				jitter.mean / 1e6, jitter.deviation / 1e6, jitter.maxError / 1e6, (uint32_t)jitter.count);
 		}
+		TaskBase::GetPool()->PrintStats("tasks");
+		ObjectBase::GetPool()->PrintStats("objects");
 
 		printf("Finalizing application...\n");
 
+		ptr_delete(objectManager);
+		ptr_release(jobSystem);
+		ptr_delete(shotData);
+#ifdef __L_PROFILE
+		Profiler::ExportChromeTrace("profile.json");
+#endif
 		ptr_release(resourceManager);
 		ptr_release(winMain);
 
@@ -144,12 +254,4 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 	}
 
 	return 0;
-}
-
-DWORD DxGetTime() {
-	LARGE_INTEGER nFreq;
-	LARGE_INTEGER nCounter;
-	QueryPerformanceFrequency(&nFreq);
-	QueryPerformanceCounter(&nCounter);
-	return (DWORD)(nCounter.QuadPart * 1000 / nFreq.QuadPart);
 }
\ No newline at end of file
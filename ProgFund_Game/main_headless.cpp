@@ -0,0 +1,1408 @@
+//Headless simulation runner: updates a Scene as fast as possible, without a window or device.
+//	Build with __L_HEADLESS defined and only the engine core, e.g. on Linux:
+//	g++ -std=c++20 -O2 -pthread -D__L_HEADLESS -I. main_headless.cpp source/Engine/Scene.cpp
+//		source/Engine/JobSystem.cpp source/Engine/MemoryPool.cpp source/Engine/TaskCoroutine.cpp
+//		source/Engine/Profiler.cpp source/Engine/FrameStats.cpp source/Engine/Replay.cpp
+//		source/Engine/ObjectValue.cpp source/Engine/EntityStore.cpp source/Engine/Simd.cpp
+//		source/Engine/QuadKernel.cpp source/Game/ShotManager.cpp source/Game/ShotData.cpp
+//		source/Game/ShotBatch.cpp source/Game/ShotCollision.cpp source/Game/Laser.cpp
+//	Replays only verify against builds with the same float behaviour: keep -ffp-contract=off
+//	and don't enable -ffast-math.
+#include "pch.h"
+
+#include <atomic>
+#include <new>
+
+#include "source/Engine/Scene.hpp"
+#include "source/Engine/TaskCoroutine.hpp"
+#include "source/Engine/JobSystem.hpp"
+#include "source/Engine/Profiler.hpp"
+#include "source/Engine/FrameStats.hpp"
+#include "source/Engine/Replay.hpp"
+#include "source/Engine/ObjectValue.hpp"
+#include "source/Engine/EntityStore.hpp"
+#include "source/Engine/QuadKernel.hpp"
+#include "source/Game/ShotManager.hpp"
+#include "source/Game/ShotData.hpp"
+#include "source/Game/ShotBatch.hpp"
+#include "source/Game/ShotCollision.hpp"
+#include "source/Game/Laser.hpp"
+
+//*******************************************************************
+//Allocation counting
+//*******************************************************************
+static std::atomic<uint64_t> s_countAlloc = 0U;
+static std::atomic<uint64_t> s_sizeAlloc = 0U;
+
+//Out of line: the compiler would otherwise inline the replaced delete into callers and
+//	warn about free() meeting a pointer it knows came from operator new
+#if defined(_MSC_VER) && !defined(__clang__)
+#define ALLOC_NOINLINE __declspec(noinline)
+#else
+#define ALLOC_NOINLINE __attribute__((noinline))
+#endif
+
+//Alignments up to the default one go through malloc, larger ones through the aligned allocator,
+//	and the matching delete is told which
+static ALLOC_NOINLINE void* _Allocate(size_t size, size_t alignment) {
+	s_countAlloc.fetch_add(1U, std::memory_order_relaxed);
+	s_sizeAlloc.fetch_add(size, std::memory_order_relaxed);
+	if (size == 0U) size = 1U;
+	void* ptr;
+	if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		ptr = malloc(size);
+	else {
+#if defined(_MSC_VER)
+		ptr = _aligned_malloc(size, alignment);
+#else
+		ptr = aligned_alloc(alignment, (size + alignment - 1U) & ~(alignment - 1U));
+#endif
+	}
+	if (ptr == nullptr) throw std::bad_alloc();
+	return ptr;
+}
+static ALLOC_NOINLINE void _Free(void* ptr, size_t alignment) {
+	if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		free(ptr);
+	else {
+#if defined(_MSC_VER)
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+}
+
+//Array and nothrow forms forward to these
+void* operator new(size_t size) {
+	return _Allocate(size, 0U);
+}
+void* operator new(size_t size, std::align_val_t alignment) {
+	return _Allocate(size, (size_t)alignment);
+}
+void operator delete(void* ptr) noexcept {
+	_Free(ptr, 0U);
+}
+void operator delete(void* ptr, size_t) noexcept {
+	_Free(ptr, 0U);
+}
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+	_Free(ptr, (size_t)alignment);
+}
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept {
+	_Free(ptr, (size_t)alignment);
+}
+
+//*******************************************************************
+//Workload
+//*******************************************************************
+//Moves with the input and fires short-lived children, like an enemy firing shots
+class Emitter : public TaskBase {
+public:
+	static constexpr size_t FIRE_INTERVAL = 4U;
+	static constexpr size_t CHILD_LIFE = 120U;
+	static constexpr size_t CHILD_SPLIT = 60U;
+
+	//Splits once halfway through its life, spawning from the parallel pass
+	class Child : public TaskBase {
+	public:
+		float x, y, dx, dy;
+		bool bSplit;
+
+		Child(Scene* parent, float x, float y, float angle, bool bSplit) : TaskBase(parent), x(x), y(y), bSplit(bSplit) {
+			dx = cosf(angle) * 2.0f;
+			dy = sinf(angle) * 2.0f;
+			bThreadSafe_ = true;
+		}
+		virtual void Update() {
+			x += dx;
+			y += dy;
+			if (!bSplit && GetFrame() == CHILD_SPLIT) {
+				shared_ptr<Child> child = TaskBase::Create<Child>(GetParent(), x, y, atan2f(dy, dx) + 0.5f, true);
+				child->SetEndFrame(CHILD_LIFE - CHILD_SPLIT);
+				GetParent()->AddTask(child);
+				bSplit = true;
+			}
+		}
+
+		virtual void Serialize(SnapshotWriter* writer) {
+			float data[4] = { x, y, dx, dy };
+			writer->Write(data);
+			writer->Write(bSplit);
+		}
+		virtual void Restore(SnapshotReader* reader) {
+			float data[4];
+			reader->Read(data);
+			reader->Read(bSplit);
+			x = data[0]; y = data[1]; dx = data[2]; dy = data[3];
+		}
+	};
+
+	float x, y;
+	float angle;
+
+	Emitter(Scene* parent, float x, float y) : TaskBase(parent), x(x), y(y) {
+		angle = 0;
+	}
+	virtual void Update() {
+		Scene* scene = GetParent();
+		float speed = scene->IsKeyHeld(VirtualKey::Slow) ? 1.0f : 3.0f;
+		if (scene->IsKeyHeld(VirtualKey::Left)) x -= speed;
+		if (scene->IsKeyHeld(VirtualKey::Right)) x += speed;
+		if (scene->IsKeyHeld(VirtualKey::Up)) y -= speed;
+		if (scene->IsKeyHeld(VirtualKey::Down)) y += speed;
+
+		angle += 0.05f;
+		size_t interval = scene->IsKeyHeld(VirtualKey::Shot) ? 1U : FIRE_INTERVAL;
+		if (GetFrame() % interval == 0U) {
+			float spread = (float)scene->GetRandom()->GetReal(-0.2, 0.2);
+			shared_ptr<Child> child = TaskBase::Create<Child>(scene, x, y, angle + spread, false);
+			child->SetEndFrame(CHILD_LIFE);
+			scene->AddTask(child);
+		}
+	}
+
+	virtual void Serialize(SnapshotWriter* writer) {
+		float data[3] = { x, y, angle };
+		writer->Write(data);
+	}
+	virtual void Restore(SnapshotReader* reader) {
+		float data[3];
+		reader->Read(data);
+		x = data[0]; y = data[1]; angle = data[2];
+	}
+};
+
+//Identifies this workload in replays
+static constexpr uint32_t SCENE_ID_EMITTER = 0x454d4954U;
+
+//*******************************************************************
+//Microbenchmarks
+//*******************************************************************
+template<class F>
+static double _MeasureNs(size_t countOp, F&& func) {
+	auto timeStart = stdch::steady_clock::now();
+	func();
+	auto timeEnd = stdch::steady_clock::now();
+	return stdch::duration<double, std::nano>(timeEnd - timeStart).count() / countOp;
+}
+
+static const char* _GetMatchText(bool bMatch) {
+	return bMatch ? "matches" : "DIFFERS FROM";
+}
+
+//Kernel comparisons: a run gives its time per unit, whether its output matched the reference
+//	and anything else to print after that
+struct KernelResult {
+	double time;
+	bool bMatch;
+	std::string detail;
+};
+//Runs func for every level in the list the CPU supports, printing one line each with the
+//	speedup over timeReference
+template<class F>
+static void _BenchKernels(const char* label, std::initializer_list<SimdLevel> listLevel, double scale, const char* unit,
+	double timeReference, const char* nameReference, F&& func)
+{
+	for (SimdLevel iLevel : listLevel) {
+		if (CpuFeature::Resolve(iLevel) != iLevel) continue;
+
+		KernelResult result = func(iLevel);
+		printf("  %s%-6s: %.3f %s (%.1fx), %s %s%s\n", label, CpuFeature::GetName(iLevel), result.time / scale, unit,
+			timeReference / result.time, _GetMatchText(result.bMatch), nameReference, result.detail.c_str());
+	}
+}
+
+//Object values: string-keyed unordered_map against ObjectValueMap with literal keys
+static void _BenchObjectValue(size_t countObject) {
+	constexpr size_t COUNT_PASS = 50U;
+	size_t countOp = countObject * COUNT_PASS * 4U;
+
+	std::vector<std::unordered_map<std::string, DWORD>> listMap(countObject);
+	std::vector<ObjectValueMap> listFlat(countObject);
+	volatile DWORD sink = 0U;
+
+	double timeMap = _MeasureNs(countOp, [&]() {
+		for (size_t iPass = 0; iPass < COUNT_PASS; ++iPass) {
+			for (auto& iMap : listMap) {
+				iMap["speed"] += 1U;
+				iMap["angle"] += 2U;
+				sink = sink + iMap["graze"] + iMap["life"];
+			}
+		}
+	});
+	double timeFlat = _MeasureNs(countOp, [&]() {
+		for (size_t iPass = 0; iPass < COUNT_PASS; ++iPass) {
+			for (auto& iMap : listFlat) {
+				iMap["speed"_key] += 1U;
+				iMap["angle"_key] += 2U;
+				sink = sink + iMap["graze"_key] + iMap["life"_key];
+			}
+		}
+	});
+	printf("Object values, %u objects x 4 keys:\n", (uint32_t)countObject);
+	printf("  std::unordered_map<std::string>: %.2f ns/op\n", timeMap);
+	printf("  ObjectValueMap:                  %.2f ns/op (%.1fx)\n", timeFlat, timeMap / timeFlat);
+}
+
+//Entity motion: heap-allocated virtual objects against EntityStore chunks
+struct BenchMover {
+	virtual ~BenchMover() {}
+	virtual void Update() = 0;
+};
+struct BenchShot : public BenchMover {
+	float x, y, speedX, speedY;
+	uint32_t life;
+	virtual void Update() {
+		x += speedX;
+		y += speedY;
+		++life;
+	}
+};
+struct BenchPosition { float x, y; };
+struct BenchVelocity { float x, y; };
+struct BenchLife { uint32_t frame; };
+
+static void _BenchEntity(size_t countEntity) {
+	constexpr size_t COUNT_PASS = 100U;
+	size_t countOp = countEntity * COUNT_PASS;
+
+	//Shuffled like a long-running heap, where consecutive objects are rarely neighbours
+	RandomGenerator random(1U);
+	std::vector<std::unique_ptr<BenchMover>> listObject;
+	for (size_t i = 0; i < countEntity; ++i) {
+		auto obj = std::make_unique<BenchShot>();
+		obj->x = obj->y = 0.0f;
+		obj->speedX = obj->speedY = 1.0f;
+		obj->life = 0U;
+		listObject.push_back(std::move(obj));
+	}
+	for (size_t i = listObject.size(); i > 1U; --i)
+		std::swap(listObject[i - 1U], listObject[(size_t)random.GetInt(0, i - 1U)]);
+
+	EntityStore store;
+	size_t archetypeShot = store.RegisterArchetype<BenchPosition, BenchVelocity, BenchLife>(TypeObject::Shot);
+	for (size_t i = 0; i < countEntity; ++i)
+		*store.Get<BenchVelocity>(store.Create(archetypeShot)) = BenchVelocity{ 1.0f, 1.0f };
+
+	double timeObject = _MeasureNs(countOp, [&]() {
+		for (size_t iPass = 0; iPass < COUNT_PASS; ++iPass) {
+			for (auto& iObject : listObject)
+				iObject->Update();
+		}
+	});
+	double timeStore = _MeasureNs(countOp, [&]() {
+		for (size_t iPass = 0; iPass < COUNT_PASS; ++iPass) {
+			store.ForEachChunk<BenchPosition, BenchVelocity, BenchLife>([](size_t count, EntityHandle*,
+				BenchPosition* position, BenchVelocity* velocity, BenchLife* life)
+			{
+				for (size_t i = 0; i < count; ++i) {
+					position[i].x += velocity[i].x;
+					position[i].y += velocity[i].y;
+					++life[i].frame;
+				}
+			});
+		}
+	});
+	printf("Entity update, %u entities:\n", (uint32_t)countEntity);
+	printf("  Virtual objects: %.2f ns/entity\n", timeObject);
+	printf("  EntityStore:     %.2f ns/entity (%.1fx)\n", timeStore, timeObject / timeStore);
+}
+
+//Shot motion: every kernel from the same start, checked against the scalar result
+static void _BenchShot(size_t countShot) {
+	constexpr size_t COUNT_FRAME = 300U;
+
+	auto Spawn = [&](ShotManager* manager) {
+		RandomGenerator random(7U);
+		manager->Clear();
+		manager->Reserve(countShot);
+		//Large clip rect so the whole count stays alive for the run
+		manager->SetClipRect(-1e6f, -1e6f, 1e6f, 1e6f);
+		for (size_t i = 0; i < countShot; ++i) {
+			ShotManager::ShotParam param;
+			param.x = (float)random.GetReal(0.0, 640.0);
+			param.y = (float)random.GetReal(0.0, 480.0);
+			param.speed = (float)random.GetReal(0.5, 4.0);
+			param.angle = (float)random.GetReal(0.0, GM_PI_X2);
+			param.accel = (float)random.GetReal(-0.02, 0.02);
+			param.maxSpeed = param.accel > 0.0f ? 6.0f : 0.5f;
+			param.angularVelocity = (i % 4U == 0U) ? (float)random.GetReal(-0.02, 0.02) : 0.0f;
+			param.graphic = (uint16_t)(i % 64U);
+			param.flags = 0U;
+			manager->AddShot(param);
+		}
+	};
+
+	printf("Shot update, %u shots, %u frames (CPU supports %s):\n", (uint32_t)countShot,
+		(uint32_t)COUNT_FRAME, CpuFeature::GetName(CpuFeature::GetSimdLevel()));
+
+	ShotManager reference;
+	reference.SetKernel(SimdLevel::Scalar);
+	Spawn(&reference);
+	double timeScalar = _MeasureNs(COUNT_FRAME, [&]() {
+		for (size_t i = 0; i < COUNT_FRAME; ++i)
+			reference.Update();
+	});
+	printf("  Scalar: %.3f ms/frame\n", timeScalar / 1e6);
+
+	_BenchKernels("", { SimdLevel::SSE2, SimdLevel::AVX }, 1e6, "ms/frame", timeScalar, "scalar", [&](SimdLevel iLevel) {
+		ShotManager manager;
+		manager.SetKernel(iLevel);
+		Spawn(&manager);
+		double time = _MeasureNs(COUNT_FRAME, [&]() {
+			for (size_t i = 0; i < COUNT_FRAME; ++i)
+				manager.Update();
+		});
+
+		bool bMatch = manager.GetCount() == reference.GetCount();
+		size_t sizeCompare = manager.GetCount() * sizeof(float);
+		bMatch = bMatch && memcmp(manager.GetX(), reference.GetX(), sizeCompare) == 0;
+		bMatch = bMatch && memcmp(manager.GetY(), reference.GetY(), sizeCompare) == 0;
+		bMatch = bMatch && memcmp(manager.GetSpeed(), reference.GetSpeed(), sizeCompare) == 0;
+		return KernelResult{ time, bMatch };
+	});
+}
+
+//Shot data: parsing the text definition against loading the binary cache built from it
+static void _BenchShotData(size_t countLoad) {
+	std::string pathText = PathProperty::GetWorkingDirectory() + "resource/data/shot_data.txt";
+	//The cache goes to the temp directory, not next to the game's own
+	std::string pathCache = (stdfs::temp_directory_path() / "ProgFund_bench_shot_data.cache").string();
+	stdfs::remove(pathCache);
+
+	ShotDataTable table;
+	table.Load(pathText, pathCache);
+	if (table.IsCached())
+		throw EngineError("ShotDataTable: The cache was used before it was written.");
+	std::vector<ShotGraphic> listParsed(table.GetShotData(), table.GetShotData() + table.GetShotCount());
+
+	double timeText = _MeasureNs(countLoad, [&]() {
+		for (size_t i = 0; i < countLoad; ++i)
+			table.LoadText(pathText);
+	});
+	double timeCache = _MeasureNs(countLoad, [&]() {
+		for (size_t i = 0; i < countLoad; ++i)
+			table.Load(pathText, pathCache);
+	});
+
+	bool bMatch = table.IsCached() && table.GetShotCount() == listParsed.size()
+		&& memcmp(table.GetShotData(), listParsed.data(), listParsed.size() * sizeof(ShotGraphic)) == 0;
+	stdfs::remove(pathCache);
+	printf("Shot data, %u shot IDs, %u delay IDs, %u loads:\n", (uint32_t)table.GetShotCount(),
+		(uint32_t)table.GetDelayCount(), (uint32_t)countLoad);
+	printf("  Text:  %.1f us/load\n", timeText / 1e3);
+	printf("  Cache: %.1f us/load (%.1fx), %s the text\n", timeCache / 1e3, timeText / timeCache,
+		_GetMatchText(bMatch));
+}
+
+//Shot rendering, CPU side: expanded quads against packed instances. The instances are
+//	expanded here the way shot_instanced.fx does it and checked against the quads.
+static void _BenchShotRender(size_t countShot) {
+	constexpr size_t COUNT_FRAME = 100U;
+
+	ShotDataTable table;
+	table.LoadText(PathProperty::GetWorkingDirectory() + "resource/data/shot_data.txt");
+
+	RandomGenerator random(11U);
+	ShotManager manager;
+	manager.Reserve(countShot);
+	for (size_t i = 0; i < countShot; ++i) {
+		ShotManager::ShotParam param = {};
+		param.x = (float)random.GetReal(0.0, 640.0);
+		param.y = (float)random.GetReal(0.0, 480.0);
+		param.angle = (float)random.GetReal(0.0, GM_PI_X2);
+		param.graphic = (uint16_t)random.GetInt(1, (int64_t)table.GetShotCount() - 1);
+		manager.AddShot(param);
+	}
+
+	ShotBatchList listQuad;
+	ShotInstanceList listInstance;
+	double timeQuad = _MeasureNs(COUNT_FRAME, [&]() {
+		for (size_t i = 0; i < COUNT_FRAME; ++i) {
+			listQuad.Clear();
+			listQuad.AddShots(&manager, &table, 0U, i);
+		}
+	});
+	double timeInstance = _MeasureNs(COUNT_FRAME, [&]() {
+		for (size_t i = 0; i < COUNT_FRAME; ++i) {
+			listInstance.Clear();
+			listInstance.AddShots(&manager, &table, 0U, i);
+		}
+	});
+
+	float errorMax = 0.0f;
+	bool bMatch = listQuad.GetQuadCount() == listInstance.GetInstanceCount()
+		&& listQuad.GetBatches().size() == listInstance.GetBatches().size();
+	const ShotDataTable::Atlas& atlas = table.GetShotAtlas();
+	for (size_t i = 0; bMatch && i < listInstance.GetInstanceCount(); ++i) {
+		const ShotInstance* instance = &listInstance.GetInstances()[i];
+		const ShotGraphic* graphic = table.GetShot((uint16_t)instance->graphic);
+		float scale = instance->scale / 256.0f;
+		float width = (graphic->u1 - graphic->u0) * atlas.width * scale;
+		float height = (graphic->v1 - graphic->v0) * atlas.height * scale;
+		float c = instance->rotation[0] / 32767.0f;
+		float s = instance->rotation[1] / 32767.0f;
+		for (size_t iCorner = 0; iCorner < 4U; ++iCorner) {
+			float lx = ((iCorner & 1U) - 0.5f) * width;
+			float ly = ((iCorner >> 1) - 0.5f) * height;
+			const QuadVertex* vertex = &listQuad.GetVertices()[i * 4U + iCorner];
+			errorMax = std::max(errorMax, fabsf(lx * c - ly * s + instance->x - 0.5f - vertex->x));
+			errorMax = std::max(errorMax, fabsf(lx * s + ly * c + instance->y - 0.5f - vertex->y));
+		}
+	}
+	bMatch = bMatch && errorMax < 0.01f;
+
+	size_t sizeQuad = listQuad.GetQuadCount() * sizeof(QuadVertex) * 4U;
+	size_t sizeInstance = listInstance.GetInstanceCount() * sizeof(ShotInstance);
+	printf("Shot render data, %u shots, %u batches:\n", (uint32_t)countShot, (uint32_t)listQuad.GetBatches().size());
+	printf("  Quads:     %.3f ms/frame, %u KiB\n", timeQuad / 1e6, (uint32_t)(sizeQuad / 1024U));
+	printf("  Instances: %.3f ms/frame, %u KiB (%.1fx less), %s the quads (max error %.4f px)\n",
+		timeInstance / 1e6, (uint32_t)(sizeInstance / 1024U), (double)sizeQuad / sizeInstance,
+		_GetMatchText(bMatch), errorMax);
+}
+
+//The per-sprite path QuadKernel replaces: a world matrix per sprite as RenderObject::CreateWorldMatrix2D
+//	builds it, identity times rotation as D3DXMatrixMultiply does, and the four SetDestRect corners put
+//	through it as D3DXVec3TransformCoord does. The half pixel bias is left to the caller, as with the kernel.
+struct BenchMatrix {
+	float m[4][4];
+};
+static void _BenchMatrixMultiply(BenchMatrix* dst, const BenchMatrix& a, const BenchMatrix& b) {
+	BenchMatrix res;
+	for (size_t iRow = 0; iRow < 4U; ++iRow) {
+		for (size_t iCol = 0; iCol < 4U; ++iCol) {
+			res.m[iRow][iCol] = a.m[iRow][0] * b.m[0][iCol] + a.m[iRow][1] * b.m[1][iCol]
+				+ a.m[iRow][2] * b.m[2][iCol] + a.m[iRow][3] * b.m[3][iCol];
+		}
+	}
+	*dst = res;
+}
+static void _BuildQuadsPerSprite(const QuadSource& src, size_t count, QuadVertex* dst) {
+	const BenchMatrix identity = { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+	for (size_t i = 0; i < count; ++i) {
+		//angleX and angleY are 0 in 2D; angleZ's sine is negated, the kernel rotates the other way
+		float c = src.cos[i];
+		float s = -src.sin[i];
+		BenchMatrix rotation = identity;
+		rotation.m[0][0] = c;
+		rotation.m[0][1] = -s;
+		rotation.m[1][0] = s;
+		rotation.m[1][1] = c;
+		BenchMatrix world;
+		_BenchMatrixMultiply(&world, identity, rotation);
+		world.m[3][0] = src.x[i];
+		world.m[3][1] = src.y[i];
+
+		float hw = src.halfWidth[i];
+		float hh = src.halfHeight[i];
+		const float listCorner[4][2] = { { -hw, -hh }, { hw, -hh }, { -hw, hh }, { hw, hh } };
+		const float listUV[4][2] = { { src.u0[i], src.v0[i] }, { src.u1[i], src.v0[i] },
+			{ src.u0[i], src.v1[i] }, { src.u1[i], src.v1[i] } };
+		for (size_t iCorner = 0; iCorner < 4U; ++iCorner) {
+			float x = listCorner[iCorner][0];
+			float y = listCorner[iCorner][1];
+			const float z = 1.0f;
+			float w = x * world.m[0][3] + y * world.m[1][3] + z * world.m[2][3] + world.m[3][3];
+			QuadVertex* vertex = &dst[i * 4U + iCorner];
+			vertex->x = (x * world.m[0][0] + y * world.m[1][0] + z * world.m[2][0] + world.m[3][0]) / w;
+			vertex->y = (x * world.m[0][1] + y * world.m[1][1] + z * world.m[2][1] + world.m[3][1]) / w;
+			vertex->z = z;
+			vertex->color = src.color[i];
+			vertex->u = listUV[iCorner][0];
+			vertex->v = listUV[iCorner][1];
+		}
+	}
+}
+
+//Quad expansion: QuadKernel against the per-sprite matrix path above, and its SIMD kernels against
+//	its scalar one, on random SoA input
+static void _BenchQuad(size_t countQuad) {
+	constexpr size_t COUNT_PASS = 200U;
+	constexpr size_t COUNT_FLOAT = 10U;
+
+	RandomGenerator random(13U);
+	std::vector<float> listFloat[COUNT_FLOAT];
+	std::vector<uint32_t> listColor(countQuad);
+	for (std::vector<float>& iList : listFloat)
+		iList.resize(countQuad);
+	for (size_t i = 0; i < countQuad; ++i) {
+		float angle = (float)random.GetReal(0.0, GM_PI_X2);
+		listFloat[0][i] = (float)random.GetReal(0.0, 640.0);
+		listFloat[1][i] = (float)random.GetReal(0.0, 480.0);
+		listFloat[2][i] = cosf(angle);
+		listFloat[3][i] = sinf(angle);
+		listFloat[4][i] = (float)random.GetReal(2.0, 32.0);
+		listFloat[5][i] = (float)random.GetReal(2.0, 32.0);
+		listFloat[6][i] = (float)random.GetReal(0.0, 0.5);
+		listFloat[7][i] = (float)random.GetReal(0.0, 0.5);
+		listFloat[8][i] = (float)random.GetReal(0.5, 1.0);
+		listFloat[9][i] = (float)random.GetReal(0.5, 1.0);
+		listColor[i] = (uint32_t)random.Next();
+	}
+	QuadSource source = {
+		listFloat[0].data(), listFloat[1].data(), listFloat[2].data(), listFloat[3].data(),
+		listFloat[4].data(), listFloat[5].data(), listFloat[6].data(), listFloat[7].data(),
+		listFloat[8].data(), listFloat[9].data(), listColor.data(),
+	};
+
+	printf("Quad expansion, %u quads, %u passes (CPU supports %s):\n", (uint32_t)countQuad,
+		(uint32_t)COUNT_PASS, CpuFeature::GetName(CpuFeature::GetSimdLevel()));
+
+	std::vector<QuadVertex> listSprite(countQuad * 4U);
+	double timeSprite = _MeasureNs(countQuad * COUNT_PASS, [&]() {
+		for (size_t i = 0; i < COUNT_PASS; ++i)
+			_BuildQuadsPerSprite(source, countQuad, listSprite.data());
+	});
+	printf("  Per-sprite matrix: %.3f ns/quad\n", timeSprite);
+
+	std::vector<QuadVertex> listReference(countQuad * 4U);
+	double timeScalar = _MeasureNs(countQuad * COUNT_PASS, [&]() {
+		for (size_t i = 0; i < COUNT_PASS; ++i)
+			QuadKernel::Build(source, countQuad, listReference.data(), SimdLevel::Scalar);
+	});
+	//Operation order differs from the kernels', so only closeness is expected
+	float errorMax = 0.0f;
+	for (size_t i = 0; i < listReference.size(); ++i) {
+		errorMax = std::max(errorMax, fabsf(listReference[i].x - listSprite[i].x));
+		errorMax = std::max(errorMax, fabsf(listReference[i].y - listSprite[i].y));
+	}
+	printf("  Scalar: %.3f ns/quad (%.1fx per-sprite), max %.5f px from per-sprite\n", timeScalar,
+		timeSprite / timeScalar, errorMax);
+
+	_BenchKernels("", { SimdLevel::SSE2, SimdLevel::AVX }, 1.0, "ns/quad", timeScalar, "scalar", [&](SimdLevel iLevel) {
+		std::vector<QuadVertex> listVertex(countQuad * 4U);
+		double time = _MeasureNs(countQuad * COUNT_PASS, [&]() {
+			for (size_t i = 0; i < COUNT_PASS; ++i)
+				QuadKernel::Build(source, countQuad, listVertex.data(), iLevel);
+		});
+
+		bool bMatch = memcmp(listVertex.data(), listReference.data(), listVertex.size() * sizeof(QuadVertex)) == 0;
+		return KernelResult{ time, bMatch, StringUtility::Format(" (%.1fx per-sprite)", timeSprite / time) };
+	});
+}
+
+//Shot collision: testing every shot against the player against QueryAll, and a grid build plus one query per frame.
+//	Shots move between frames, outside the timing. The build is shared by every query of a frame,
+//	so the grid also reports how many queries it takes to beat testing every shot for each.
+static void _BenchCollision(size_t countShot) {
+	constexpr size_t COUNT_FRAME = 100U;
+	constexpr float PLAYER_X = 320.0f;
+	constexpr float PLAYER_Y = 400.0f;
+	constexpr float RADIUS_HIT = 2.0f;
+	constexpr float RADIUS_GRAZE = 24.0f;
+
+	ShotDataTable table;
+	table.LoadText(PathProperty::GetWorkingDirectory() + "resource/data/shot_data.txt");
+	const ShotGraphic* listShotData = table.GetShotData();
+
+	auto Spawn = [&](ShotManager* manager) {
+		RandomGenerator random(17U);
+		manager->Reserve(countShot);
+		manager->SetClipRect(-1e6f, -1e6f, 1e6f, 1e6f);
+		for (size_t i = 0; i < countShot; ++i) {
+			ShotManager::ShotParam param = {};
+			param.x = (float)random.GetReal(0.0, 640.0);
+			param.y = (float)random.GetReal(0.0, 480.0);
+			param.speed = (float)random.GetReal(0.1, 0.5);
+			param.angle = (float)random.GetReal(0.0, GM_PI_X2);
+			param.graphic = (uint16_t)random.GetInt(1, (int64_t)table.GetShotCount() - 1);
+			//Some without a graphic, which don't collide
+			if (i % 8U == 0U)
+				param.graphic = (uint16_t)table.GetShotCount();
+			manager->AddShot(param);
+		}
+	};
+
+	printf("Shot collision, %u shots, %u frames (CPU supports %s):\n", (uint32_t)countShot,
+		(uint32_t)COUNT_FRAME, CpuFeature::GetName(CpuFeature::GetSimdLevel()));
+
+	//Reference: every shot, every frame
+	std::vector<std::vector<uint32_t>> listReferenceHit(COUNT_FRAME);
+	std::vector<std::vector<uint32_t>> listReferenceGraze(COUNT_FRAME);
+	double timeAll = 0.0;
+	{
+		ShotManager manager;
+		Spawn(&manager);
+		std::vector<uint32_t> listHit(countShot), listGraze(countShot);
+		for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+			size_t countHit = 0U, countGraze = 0U;
+			timeAll += _MeasureNs(1U, [&]() {
+				const float* px = manager.GetX();
+				const float* py = manager.GetY();
+				const uint16_t* listGraphic = manager.GetGraphic();
+				for (size_t i = 0; i < manager.GetCount(); ++i) {
+					if (listGraphic[i] >= table.GetShotCount() || !listShotData[listGraphic[i]].IsDefined()) continue;
+					float radius = listShotData[listGraphic[i]].radius;
+					float dx = px[i] - PLAYER_X;
+					float dy = py[i] - PLAYER_Y;
+					float distSq = dx * dx + dy * dy;
+					float reachHit = radius + RADIUS_HIT;
+					float reachGraze = radius + RADIUS_GRAZE;
+					if (distSq <= reachHit * reachHit)
+						listHit[countHit++] = (uint32_t)i;
+					else if (distSq <= reachGraze * reachGraze)
+						listGraze[countGraze++] = (uint32_t)i;
+				}
+			});
+			listReferenceHit[iFrame].assign(listHit.begin(), listHit.begin() + countHit);
+			listReferenceGraze[iFrame].assign(listGraze.begin(), listGraze.begin() + countGraze);
+			manager.Update();
+		}
+		timeAll /= COUNT_FRAME;
+		printf("  All shots:   %.3f ms/frame\n", timeAll / 1e6);
+	}
+
+	//QueryAll, the path for a single query a frame: the same test without a grid, in storage order
+	_BenchKernels("QueryAll ", { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2 }, 1e6, "ms/frame",
+		timeAll, "all shots", [&](SimdLevel iLevel)
+	{
+		ShotManager manager;
+		Spawn(&manager);
+		ShotGrid grid;
+		grid.SetKernel(iLevel);
+
+		double timeQuery = 0.0;
+		bool bMatch = true;
+		for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+			timeQuery += _MeasureNs(1U, [&]() {
+				grid.QueryAll(&manager, &table, PLAYER_X, PLAYER_Y, RADIUS_HIT, RADIUS_GRAZE);
+			});
+			bMatch = bMatch && std::equal(grid.GetHits(), grid.GetHits() + grid.GetHitCount(),
+				listReferenceHit[iFrame].begin(), listReferenceHit[iFrame].end())
+				&& std::equal(grid.GetGrazes(), grid.GetGrazes() + grid.GetGrazeCount(),
+				listReferenceGraze[iFrame].begin(), listReferenceGraze[iFrame].end());
+			manager.Update();
+		}
+		return KernelResult{ timeQuery / COUNT_FRAME, bMatch };
+	});
+
+	//Build plus one query against all shots
+	_BenchKernels("Grid ", { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX }, 1e6, "ms/frame",
+		timeAll, "all shots", [&](SimdLevel iLevel)
+	{
+		ShotManager manager;
+		Spawn(&manager);
+		ShotGrid grid;
+		grid.SetKernel(iLevel);
+
+		double timeBuild = 0.0;
+		double timeQuery = 0.0;
+		bool bMatch = true;
+		size_t countHitTotal = 0U, countGrazeTotal = 0U;
+		for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+			timeBuild += _MeasureNs(1U, [&]() {
+				grid.Build(&manager, &table);
+			});
+			//A QueryAll in between has to leave the built grid alone
+			if (iFrame == 0U)
+				grid.QueryAll(&manager, &table, PLAYER_X, PLAYER_Y, RADIUS_HIT, RADIUS_GRAZE);
+			timeQuery += _MeasureNs(1U, [&]() {
+				grid.Query(PLAYER_X, PLAYER_Y, RADIUS_HIT, RADIUS_GRAZE);
+			});
+
+			//Grid order differs from storage order
+			std::vector<uint32_t> listHit(grid.GetHits(), grid.GetHits() + grid.GetHitCount());
+			std::vector<uint32_t> listGraze(grid.GetGrazes(), grid.GetGrazes() + grid.GetGrazeCount());
+			std::sort(listHit.begin(), listHit.end());
+			std::sort(listGraze.begin(), listGraze.end());
+			bMatch = bMatch && listHit == listReferenceHit[iFrame] && listGraze == listReferenceGraze[iFrame];
+			countHitTotal += listHit.size();
+			countGrazeTotal += listGraze.size();
+			manager.Update();
+		}
+		timeBuild /= COUNT_FRAME;
+		timeQuery /= COUNT_FRAME;
+		return KernelResult{ timeBuild + timeQuery, bMatch, StringUtility::Format(
+			" (%.2f us/query, ahead from %u queries/frame, %u hits, %u grazes)", timeQuery / 1e3,
+			(uint32_t)ceil(timeBuild / std::max(timeAll - timeQuery, 1.0)),
+			(uint32_t)countHitTotal, (uint32_t)countGrazeTotal) };
+	});
+}
+
+//Laser collision: a curvy laser tested at random points along it, every segment against the tree.
+//	The head advances one node per frame, so the first query of a frame also pays for the refit.
+static void _BenchLaser(size_t countNode) {
+	constexpr size_t COUNT_FRAME = 100U;
+	constexpr size_t COUNT_QUERY = 200U;
+	constexpr float WIDTH = 16.0f;
+	constexpr float RADIUS_HIT = 2.0f;
+	constexpr float RADIUS_GRAZE = 24.0f;
+
+	//Nodes 4 pixels apart along a wave; frame n holds nodes n + 1 to n + countNode
+	auto GetNodeX = [](size_t seq) { return (float)seq * 4.0f; };
+	auto GetNodeY = [](size_t seq) { return 240.0f + 160.0f * sinf((float)seq * 0.05f); };
+
+	RandomGenerator random(19U);
+	std::vector<float> listQueryX(COUNT_FRAME * COUNT_QUERY);
+	std::vector<float> listQueryY(COUNT_FRAME * COUNT_QUERY);
+	for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+		for (size_t iQuery = 0; iQuery < COUNT_QUERY; ++iQuery) {
+			size_t index = iFrame * COUNT_QUERY + iQuery;
+			listQueryX[index] = (float)random.GetReal(GetNodeX(iFrame + 1U), GetNodeX(iFrame + countNode));
+			listQueryY[index] = (float)random.GetReal(40.0, 440.0);
+		}
+	}
+
+	printf("Laser collision, %u nodes, %u frames of %u queries (CPU supports %s):\n", (uint32_t)countNode,
+		(uint32_t)COUNT_FRAME, (uint32_t)COUNT_QUERY, CpuFeature::GetName(CpuFeature::GetSimdLevel()));
+
+	float reachHit = WIDTH * 0.5f + RADIUS_HIT;
+	float reachGraze = WIDTH * 0.5f + RADIUS_GRAZE;
+
+	//Reference: every segment, with the float operations of Laser's kernels
+	std::vector<Laser::Contact> listReference(COUNT_FRAME * COUNT_QUERY);
+	double timeAll = 0.0;
+	{
+		std::vector<float> listX(countNode), listY(countNode);
+		for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+			for (size_t i = 0; i < countNode; ++i) {
+				listX[i] = GetNodeX(iFrame + 1U + i);
+				listY[i] = GetNodeY(iFrame + 1U + i);
+			}
+			timeAll += _MeasureNs(COUNT_QUERY, [&]() {
+				for (size_t iQuery = 0; iQuery < COUNT_QUERY; ++iQuery) {
+					size_t index = iFrame * COUNT_QUERY + iQuery;
+					float x = listQueryX[index];
+					float y = listQueryY[index];
+					float distMin = INFINITY;
+					for (size_t i = 0; i + 1U < countNode; ++i) {
+						float dx = listX[i + 1U] - listX[i];
+						float dy = listY[i + 1U] - listY[i];
+						float lengthSq = dx * dx + dy * dy;
+						float t = (x - listX[i]) * dx + (y - listY[i]) * dy;
+						t = lengthSq > 0.0f ? t / lengthSq : 0.0f;
+						t = t > 0.0f ? t : 0.0f;
+						t = t < 1.0f ? t : 1.0f;
+						float ex = x - (listX[i] + t * dx);
+						float ey = y - (listY[i] + t * dy);
+						distMin = std::min(distMin, ex * ex + ey * ey);
+					}
+					listReference[index] = distMin <= reachHit * reachHit ? Laser::Contact::Hit
+						: (distMin <= reachGraze * reachGraze ? Laser::Contact::Graze : Laser::Contact::None);
+				}
+			});
+		}
+		timeAll /= COUNT_FRAME;
+		printf("  Every segment: %.3f us/query\n", timeAll / 1e3);
+	}
+
+	_BenchKernels("Tree ", { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX }, 1e3, "us/query",
+		timeAll, "every segment", [&](SimdLevel iLevel)
+	{
+		Laser laser(countNode);
+		laser.SetWidth(WIDTH);
+		for (size_t i = 0; i < countNode; ++i)
+			laser.AddNode(GetNodeX(i), GetNodeY(i));
+
+		std::vector<Laser::Contact> listContact(COUNT_QUERY);
+		double timeQuery = 0.0;
+		bool bMatch = true;
+		size_t countHit = 0U, countGraze = 0U;
+		for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+			laser.AddNode(GetNodeX(iFrame + countNode), GetNodeY(iFrame + countNode));
+			timeQuery += _MeasureNs(COUNT_QUERY, [&]() {
+				for (size_t iQuery = 0; iQuery < COUNT_QUERY; ++iQuery) {
+					size_t index = iFrame * COUNT_QUERY + iQuery;
+					listContact[iQuery] = laser.Test(listQueryX[index], listQueryY[index],
+						RADIUS_HIT, RADIUS_GRAZE, iLevel);
+				}
+			});
+
+			for (size_t iQuery = 0; iQuery < COUNT_QUERY; ++iQuery) {
+				Laser::Contact contact = listContact[iQuery];
+				bMatch = bMatch && contact == listReference[iFrame * COUNT_QUERY + iQuery];
+				countHit += contact == Laser::Contact::Hit;
+				countGraze += contact == Laser::Contact::Graze;
+			}
+		}
+		return KernelResult{ timeQuery / COUNT_FRAME, bMatch,
+			StringUtility::Format(" (%u hits, %u grazes)", (uint32_t)countHit, (uint32_t)countGraze) };
+	});
+}
+
+//Shot cancel: a bomb deleting the shots in a circle and a spell card end deleting every shot, both
+//	converting them to items, then the compaction. Per-shot DeleteShot calls into the scalar flush
+//	are the reference, and every kernel is checked to leave the same shots and items.
+static void _BenchCancel(size_t countShot) {
+	constexpr size_t COUNT_FRAME = 50U;
+	constexpr float BOMB_X = 320.0f;
+	constexpr float BOMB_Y = 240.0f;
+	constexpr float BOMB_RADIUS = 160.0f;
+
+	auto Spawn = [&](ShotManager* manager) {
+		RandomGenerator random(23U);
+		manager->Clear();
+		manager->ClearItems();
+		manager->Reserve(countShot);
+		for (size_t i = 0; i < countShot; ++i) {
+			ShotManager::ShotParam param = {};
+			param.x = (float)random.GetReal(0.0, 640.0);
+			param.y = (float)random.GetReal(0.0, 480.0);
+			param.speed = (float)random.GetReal(0.5, 4.0);
+			param.angle = (float)random.GetReal(0.0, GM_PI_X2);
+			param.graphic = (uint16_t)random.GetInt(1, 64);
+			manager->AddShot(param);
+		}
+	};
+	auto IsSame = [](ShotManager* manager, ShotManager* reference) {
+		size_t count = manager->GetCount();
+		size_t countItem = manager->GetItemCount();
+		return count == reference->GetCount() && countItem == reference->GetItemCount()
+			&& memcmp(manager->GetX(), reference->GetX(), count * sizeof(float)) == 0
+			&& memcmp(manager->GetY(), reference->GetY(), count * sizeof(float)) == 0
+			&& memcmp(manager->GetDirX(), reference->GetDirX(), count * sizeof(float)) == 0
+			&& memcmp(manager->GetDirY(), reference->GetDirY(), count * sizeof(float)) == 0
+			&& memcmp(manager->GetSpeed(), reference->GetSpeed(), count * sizeof(float)) == 0
+			&& memcmp(manager->GetGraphic(), reference->GetGraphic(), count * sizeof(uint16_t)) == 0
+			&& memcmp(manager->GetFlags(), reference->GetFlags(), count * sizeof(uint16_t)) == 0
+			&& memcmp(manager->GetItemX(), reference->GetItemX(), countItem * sizeof(float)) == 0
+			&& memcmp(manager->GetItemY(), reference->GetItemY(), countItem * sizeof(float)) == 0
+			&& memcmp(manager->GetItemGraphic(), reference->GetItemGraphic(), countItem * sizeof(uint16_t)) == 0;
+	};
+
+	printf("Shot cancel to items, %u shots, %u frames (CPU supports %s):\n", (uint32_t)countShot,
+		(uint32_t)COUNT_FRAME, CpuFeature::GetName(CpuFeature::GetSimdLevel()));
+
+	for (bool bAll : { false, true }) {
+		//Reference: the deleted shots' positions go to a list sized up front, as the batch does
+		ShotManager reference;
+		reference.SetKernel(SimdLevel::Scalar);
+		std::vector<float> listItemX(countShot), listItemY(countShot);
+		double timeReference = 0.0;
+		size_t countCancel = 0U;
+		for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+			Spawn(&reference);
+			timeReference += _MeasureNs(1U, [&]() {
+				const float* px = reference.GetX();
+				const float* py = reference.GetY();
+				countCancel = 0U;
+				for (size_t i = 0; i < reference.GetCount(); ++i) {
+					float dx = px[i] - BOMB_X;
+					float dy = py[i] - BOMB_Y;
+					if (!bAll && !(dx * dx + dy * dy <= BOMB_RADIUS * BOMB_RADIUS)) continue;
+					listItemX[countCancel] = px[i];
+					listItemY[countCancel] = py[i];
+					++countCancel;
+					reference.DeleteShot(i);
+				}
+				reference.FlushDeleted();
+			});
+		}
+		timeReference /= COUNT_FRAME;
+
+		//The same again through the batch call, kept as the state every kernel is compared with
+		Spawn(&reference);
+		if (bAll)
+			reference.DeleteAll(true);
+		else
+			reference.DeleteInCircle(BOMB_X, BOMB_Y, BOMB_RADIUS, true);
+		reference.FlushDeleted();
+		bool bMatchReference = memcmp(reference.GetItemX(), listItemX.data(), countCancel * sizeof(float)) == 0
+			&& memcmp(reference.GetItemY(), listItemY.data(), countCancel * sizeof(float)) == 0;
+
+		printf("  %s, %u shots cancelled:\n", bAll ? "Delete all" : "Delete in circle", (uint32_t)countCancel);
+		printf("    Per shot: %.3f ms, %s batch items\n", timeReference / 1e6,
+			_GetMatchText(bMatchReference));
+
+		_BenchKernels("  ", { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX, SimdLevel::AVX2 }, 1e6, "ms",
+			timeReference, "batch", [&](SimdLevel iLevel)
+		{
+			ShotManager manager;
+			manager.SetKernel(iLevel);
+			double timeCancel = 0.0;
+			double timeFlush = 0.0;
+			bool bMatch = true;
+			for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+				Spawn(&manager);
+				timeCancel += _MeasureNs(1U, [&]() {
+					if (bAll)
+						manager.DeleteAll(true);
+					else
+						manager.DeleteInCircle(BOMB_X, BOMB_Y, BOMB_RADIUS, true);
+				});
+				timeFlush += _MeasureNs(1U, [&]() {
+					manager.FlushDeleted();
+				});
+				bMatch = bMatch && IsSame(&manager, &reference);
+			}
+			timeCancel /= COUNT_FRAME;
+			timeFlush /= COUNT_FRAME;
+			return KernelResult{ timeCancel + timeFlush, bMatch, StringUtility::Format(
+				" (%.3f mask pass + %.3f flush)", timeCancel / 1e6, timeFlush / 1e6) };
+		});
+	}
+}
+
+//Scene task storage: Update and Render through the slot map scene against the std::list of
+//	shared_ptr it replaced, which is reproduced here as the reference. Every frame one task in
+//	a hundred is removed and replaced by a new one.
+static void _BenchScene() {
+	const size_t listCountTask[] = { 1000U, 10000U, 100000U };
+	constexpr size_t CHURN = 100U;
+
+	printf("Scene update + render, 1/%u of the tasks replaced per frame:\n", (uint32_t)CHURN);
+	for (size_t countTask : listCountTask) {
+		size_t countFrame = std::max<size_t>(10000000U / countTask, 10U);
+
+		std::list<shared_ptr<TaskBase>> listTask;
+		std::vector<std::list<shared_ptr<TaskBase>>::iterator> listItr;
+		for (size_t i = 0; i < countTask; ++i)
+			listItr.push_back(listTask.insert(listTask.end(), std::make_shared<Emitter::Child>(nullptr, 0.0f, 0.0f, (float)i, true)));
+		uint64_t countAllocStart = s_countAlloc.load();
+		double timeList = _MeasureNs(countFrame, [&]() {
+			for (size_t iFrame = 0; iFrame < countFrame; ++iFrame) {
+				for (size_t i = iFrame % CHURN; i < countTask; i += CHURN)
+					(*listItr[i])->SetEndFrame(0U);
+				//As the old Scene::Update did, including the shared_ptr copy per task
+				for (auto itr = listTask.begin(); itr != listTask.end();) {
+					shared_ptr<TaskBase> task = *itr;
+					if (task && task->GetFrame() < task->GetFrameEnd()) {
+						task->Update();
+						++itr;
+					}
+					else itr = listTask.erase(itr);
+				}
+				for (size_t i = iFrame % CHURN; i < countTask; i += CHURN)
+					listItr[i] = listTask.insert(listTask.end(), std::make_shared<Emitter::Child>(nullptr, 0.0f, 0.0f, (float)i, true));
+				for (shared_ptr<TaskBase>& iTask : listTask) {
+					if (!iTask->IsFinished())
+						iTask->Render();
+				}
+			}
+		});
+		uint64_t countAllocList = s_countAlloc.load() - countAllocStart;
+
+		Scene scene;
+		std::vector<TaskHandle> listHandle;
+		for (size_t i = 0; i < countTask; ++i)
+			listHandle.push_back(scene.AddTask(TaskBase::Create<Emitter::Child>(&scene, 0.0f, 0.0f, (float)i, true)));
+		countAllocStart = s_countAlloc.load();
+		double timeScene = _MeasureNs(countFrame, [&]() {
+			for (size_t iFrame = 0; iFrame < countFrame; ++iFrame) {
+				for (size_t i = iFrame % CHURN; i < countTask; i += CHURN)
+					scene.RemoveTask(listHandle[i]);
+				scene.Update();
+				for (size_t i = iFrame % CHURN; i < countTask; i += CHURN)
+					listHandle[i] = scene.AddTask(TaskBase::Create<Emitter::Child>(&scene, 0.0f, 0.0f, (float)i, true));
+				scene.Render();
+			}
+		});
+		uint64_t countAllocScene = s_countAlloc.load() - countAllocStart;
+
+		printf("  %6u tasks: std::list %8.1f us (%.1f allocations), slot map %8.1f us (%.1f allocations, %.1fx)\n",
+			(uint32_t)countTask, timeList / 1e3, (double)countAllocList / countFrame,
+			timeScene / 1e3, (double)countAllocScene / countFrame, timeList / timeScene);
+	}
+}
+
+//Snapshots: saving and restoring a scene of moving tasks, as rollback and replay seeking do,
+//	against the task count. A tenth of the tasks sleep so the timer wheel has entries.
+static void _BenchSnapshot() {
+	const size_t listCountTask[] = { 1000U, 10000U, 100000U };
+
+	printf("Scene snapshots:\n");
+	for (size_t countTask : listCountTask) {
+		size_t countPass = std::max<size_t>(1000000U / countTask, 4U);
+
+		Scene scene;
+		scene.SetSeed(1U);
+		for (size_t i = 0; i < countTask; ++i) {
+			shared_ptr<Emitter::Child> task = TaskBase::Create<Emitter::Child>(&scene, 0.0f, 0.0f, (float)i, true);
+			if (i % 10U == 0U)
+				task->Suspend(60U);
+			scene.AddTask(task);
+		}
+		scene.Update();
+
+		//The first save sizes the buffers, later ones reuse them
+		SceneSnapshot snapshot;
+		scene.SaveSnapshot(&snapshot);
+
+		uint64_t countAllocStart = s_countAlloc.load();
+		double timeSave = _MeasureNs(countPass, [&]() {
+			for (size_t iPass = 0; iPass < countPass; ++iPass)
+				scene.SaveSnapshot(&snapshot);
+		});
+		double timeLoad = _MeasureNs(countPass, [&]() {
+			for (size_t iPass = 0; iPass < countPass; ++iPass)
+				scene.LoadSnapshot(&snapshot);
+		});
+		uint64_t countAlloc = s_countAlloc.load() - countAllocStart;
+
+		printf("  %6u tasks: save %8.1f us (%.1f ns/task), load %8.1f us (%.1f ns/task), %u KB, %.1f allocations per pass\n",
+			(uint32_t)countTask, timeSave / 1e3, timeSave / countTask, timeLoad / 1e3, timeLoad / countTask,
+			(uint32_t)(snapshot.GetDataSize() / 1024U), (double)countAlloc / (countPass * 2U));
+	}
+}
+
+//Thread scaling: the emitter workload from 1 thread up to the hardware's (at least 4), at the default
+//	size and at 16 times as many emitters. The scene only dispatches to the workers from
+//	Scene::PARALLEL_TASK_MIN thread-safe tasks, the raw ParallelFor table below is what that is set from.
+static void _BenchThreads(size_t countFrame) {
+	size_t countThreadMax = std::max<size_t>(std::thread::hardware_concurrency(), 4U);
+
+	printf("Thread scaling, emitter workload (%u hardware threads):\n", std::thread::hardware_concurrency());
+	for (size_t countEmitter : { 64U, 1024U }) {
+		size_t countFrameRun = std::max<size_t>(countFrame * 64U / countEmitter, 1U);
+		double fpsSingle = 0.0;
+		for (size_t countThread = 1U; countThread <= countThreadMax; ++countThread) {
+			JobSystem jobSystem;
+			jobSystem.Initialize(countThread - 1U);
+
+			Scene scene;
+			scene.SetSeed(1U);
+			for (size_t i = 0; i < countEmitter; ++i)
+				scene.AddTask(TaskBase::Create<Emitter>(&scene, (float)(i % 16U) * 40.0f, (float)(i / 16U) * 40.0f));
+			//Past the children's lifetime, so the task count is steady
+			for (size_t i = 0; i < Emitter::CHILD_LIFE * 2U; ++i)
+				scene.Update();
+
+			uint64_t countAllocStart = s_countAlloc.load();
+			double time = _MeasureNs(countFrameRun, [&]() {
+				for (size_t i = 0; i < countFrameRun; ++i)
+					scene.Update();
+			});
+			uint64_t countAlloc = s_countAlloc.load() - countAllocStart;
+
+			double fps = 1e9 / time;
+			if (countThread == 1U) fpsSingle = fps;
+			printf("  %4u emitters, %6u tasks, %u threads: %9.1f fps (%.2fx), %u allocations in %u frames\n",
+				(uint32_t)countEmitter, (uint32_t)scene.GetTaskCount(), (uint32_t)countThread, fps, fps / fpsSingle,
+				(uint32_t)countAlloc, (uint32_t)countFrameRun);
+		}
+	}
+
+	//Moving the same tasks serially against ParallelFor, to find where dispatching starts to pay off
+	printf("ParallelFor over child updates, %u threads:\n", (uint32_t)countThreadMax);
+	JobSystem jobSystem;
+	jobSystem.Initialize(countThreadMax - 1U);
+	Scene scene;
+	for (size_t countTask : { 256U, 1024U, 4096U, 16384U, 65536U }) {
+		std::vector<shared_ptr<Emitter::Child>> listTask;
+		for (size_t i = 0; i < countTask; ++i)
+			listTask.push_back(TaskBase::Create<Emitter::Child>(&scene, 0.0f, 0.0f, (float)i, true));
+		auto UpdateRange = [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+				listTask[i]->Update();
+		};
+		JobSystem::RangeFunction func = UpdateRange;
+
+		size_t countPass = std::max<size_t>(4000000U / countTask, 16U);
+		double timeSerial = _MeasureNs(countPass, [&]() {
+			for (size_t iPass = 0; iPass < countPass; ++iPass)
+				UpdateRange(0U, countTask);
+		});
+		double timeParallel = _MeasureNs(countPass, [&]() {
+			for (size_t iPass = 0; iPass < countPass; ++iPass)
+				jobSystem.ParallelFor(countTask, Scene::PARALLEL_TASK_GRAIN, func);
+		});
+		printf("  %6u tasks: serial %8.2f us, parallel %8.2f us (%.2fx)\n", (uint32_t)countTask,
+			timeSerial / 1e3, timeParallel / 1e3, timeSerial / timeParallel);
+	}
+}
+
+//*******************************************************************
+//Checks
+//*******************************************************************
+//Replays: the emitter workload hashed at every checkpoint without workers, then with countThread
+//	threads. Enough children for the parallel pass, and they spawn from it when they split.
+static bool _CheckReplay(size_t countThread) {
+	constexpr size_t COUNT_FRAME = 600U;
+	constexpr size_t COUNT_EMITTER = 256U;
+
+	std::vector<uint64_t> listHash[2];
+	size_t countTaskMax = 0U;
+	for (size_t iRun = 0; iRun < 2U; ++iRun) {
+		JobSystem* jobSystem = nullptr;
+		if (iRun == 1U) {
+			jobSystem = new JobSystem();
+			jobSystem->Initialize(countThread - 1U);
+		}
+		{
+			Scene scene;
+			scene.SetSeed(1U);
+			for (size_t i = 0; i < COUNT_EMITTER; ++i)
+				scene.AddTask(TaskBase::Create<Emitter>(&scene, (float)(i % 16U) * 40.0f, (float)(i / 16U) * 40.0f));
+
+			RandomGenerator randomInput(0x5eed5eed5eed5eedULL);
+			InputState input = { 0U };
+			SceneSnapshot snapshotHash;
+			for (size_t iFrame = 0; iFrame < COUNT_FRAME; ++iFrame) {
+				if (iFrame % 30U == 0U)
+					input.buttons = (uint32_t)randomInput.Next() & ~(1U << (uint32_t)VirtualKey::Pause);
+				scene.SetInput(input);
+				scene.Update();
+				countTaskMax = std::max(countTaskMax, scene.GetTaskCount());
+				if (scene.GetFrame() % Replay::CHECKPOINT_INTERVAL == 0U)
+					listHash[iRun].push_back(Replay::HashScene(&scene, &snapshotHash));
+			}
+		}
+		ptr_release(jobSystem);
+	}
+
+	bool bMatch = listHash[0] == listHash[1];
+	printf("Replay, %u frames, up to %u tasks: %u checkpoints with %u threads %s the serial run\n",
+		(uint32_t)COUNT_FRAME, (uint32_t)countTaskMax, (uint32_t)listHash[1].size(), (uint32_t)countThread,
+		_GetMatchText(bMatch));
+	return bMatch;
+}
+
+//Coroutine tasks: every WaitFrames(n) resumes exactly n updates later, and the frames of finished
+//	coroutines go back to the pool for the next round instead of growing it
+static Coroutine _WaitSequence(Scene* scene, const size_t* listWait, size_t countWait, std::vector<size_t>* listFrame) {
+	for (size_t i = 0; i < countWait; ++i) {
+		listFrame->push_back(scene->GetFrame());
+		co_await WaitFrames(listWait[i]);
+	}
+	listFrame->push_back(scene->GetFrame());
+}
+static bool _CheckCoroutine() {
+	constexpr size_t COUNT_TASK = 256U;
+	constexpr size_t COUNT_ROUND = 8U;
+	static const size_t LIST_WAIT[] = { 1U, 2U, 5U, 0U, 17U, 1U, 3U };
+	constexpr size_t COUNT_WAIT = sizeof(LIST_WAIT) / sizeof(size_t);
+
+	SizeClassPool* pool = Coroutine::GetPool();
+	auto GetPoolStats = [&](size_t* pCountUsed, size_t* pCountChunk) {
+		*pCountUsed = pool->GetLargeCount();
+		*pCountChunk = 0U;
+		for (size_t iClass = 0; iClass < SizeClassPool::CLASS_COUNT; ++iClass) {
+			FixedBlockPool::Stats stats = pool->GetClassStats(iClass);
+			*pCountUsed += stats.countUsed;
+			*pCountChunk += stats.countChunk;
+		}
+	};
+
+	Scene scene;
+	std::vector<std::vector<size_t>> listFrame(COUNT_TASK);
+	bool bTiming = true;
+	bool bReuse = true;
+	size_t countChunkFirst = 0U;
+	for (size_t iRound = 0; iRound < COUNT_ROUND; ++iRound) {
+		for (size_t i = 0; i < COUNT_TASK; ++i) {
+			listFrame[i].clear();
+			scene.AddTask(TaskBase::Create<CoroutineTask>(&scene, _WaitSequence(&scene, LIST_WAIT, COUNT_WAIT, &listFrame[i])));
+		}
+		for (size_t iFrame = 0; iFrame < 100U && scene.GetTaskCount() > 0U; ++iFrame)
+			scene.Update();
+		scene.Update();
+
+		for (std::vector<size_t>& iList : listFrame) {
+			bTiming = bTiming && iList.size() == COUNT_WAIT + 1U;
+			for (size_t i = 0; bTiming && i < COUNT_WAIT; ++i)
+				bTiming = iList[i + 1U] - iList[i] == LIST_WAIT[i];
+		}
+
+		size_t countUsed, countChunk;
+		GetPoolStats(&countUsed, &countChunk);
+		if (iRound == 0U)
+			countChunkFirst = countChunk;
+		bReuse = bReuse && scene.GetTaskCount() == 0U && countUsed == 0U && countChunk == countChunkFirst;
+	}
+
+	printf("Coroutines, %u rounds of %u tasks: waits %s the requested frames, frames %s\n", (uint32_t)COUNT_ROUND,
+		(uint32_t)COUNT_TASK, bTiming ? "match" : "DON'T MATCH", bReuse ? "reused from the pool" : "LEAKED OR NOT REUSED");
+	return bTiming && bReuse;
+}
+
+static size_t _ParseArg(int argc, char** argv, const char* name, size_t def) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (strcmp(argv[i], name) == 0)
+			return (size_t)strtoull(argv[i + 1], nullptr, 10);
+	}
+	return def;
+}
+static const char* _ParseArgString(int argc, char** argv, const char* name) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (strcmp(argv[i], name) == 0)
+			return argv[i + 1];
+	}
+	return nullptr;
+}
+
+//Usage: [--frames N] [--emitters N] [--threads N] [--seed N] [--csv path]
+//	[--record path]: runs with generated input and saves the replay with checkpoints
+//	[--replay path]: plays a replay back instead, as fast as possible, and verifies the checkpoints.
+//		--emitters has to match the recording.
+//	--threads 0 runs without a job system
+//	[--bench name] [--count N]: runs a microbenchmark instead (objectvalue, entity, shot, shotdata,
+//		shotrender, quad, collision, laser, cancel, scene, snapshot, threads)
+//	[--check name] [--threads N]: runs a check instead, failing on a mismatch (replay, coroutine)
+int main(int argc, char** argv) {
+	try {
+		if (const char* nameCheck = _ParseArgString(argc, argv, "--check")) {
+			size_t countThread = std::max<size_t>(_ParseArg(argc, argv, "--threads", 4U), 1U);
+			bool bPass = false;
+			if (strcmp(nameCheck, "replay") == 0)
+				bPass = _CheckReplay(countThread);
+			else if (strcmp(nameCheck, "coroutine") == 0)
+				bPass = _CheckCoroutine();
+			else
+				throw EngineError(StringUtility::Format("Unknown check: %s", nameCheck));
+			return bPass ? 0 : 1;
+		}
+
+		if (const char* nameBench = _ParseArgString(argc, argv, "--bench")) {
+			size_t count = _ParseArg(argc, argv, "--count", 10000U);
+			if (strcmp(nameBench, "objectvalue") == 0)
+				_BenchObjectValue(count);
+			else if (strcmp(nameBench, "entity") == 0)
+				_BenchEntity(count);
+			else if (strcmp(nameBench, "shot") == 0)
+				_BenchShot(count);
+			else if (strcmp(nameBench, "shotdata") == 0)
+				_BenchShotData(count);
+			else if (strcmp(nameBench, "shotrender") == 0)
+				_BenchShotRender(count);
+			else if (strcmp(nameBench, "quad") == 0)
+				_BenchQuad(count);
+			else if (strcmp(nameBench, "collision") == 0)
+				_BenchCollision(count);
+			else if (strcmp(nameBench, "laser") == 0)
+				_BenchLaser(count);
+			else if (strcmp(nameBench, "cancel") == 0)
+				_BenchCancel(count);
+			else if (strcmp(nameBench, "scene") == 0)
+				_BenchScene();
+			else if (strcmp(nameBench, "snapshot") == 0)
+				_BenchSnapshot();
+			else if (strcmp(nameBench, "threads") == 0)
+				_BenchThreads(count);
+			else
+				throw EngineError(StringUtility::Format("Unknown benchmark: %s", nameBench));
+			return 0;
+		}
+
+		size_t countFrame = _ParseArg(argc, argv, "--frames", 10000U);
+		size_t countEmitter = _ParseArg(argc, argv, "--emitters", 64U);
+		size_t countThread = _ParseArg(argc, argv, "--threads", 1U);
+		uint64_t seed = _ParseArg(argc, argv, "--seed", 1U);
+		const char* pathCsv = _ParseArgString(argc, argv, "--csv");
+		const char* pathRecord = _ParseArgString(argc, argv, "--record");
+		const char* pathReplay = _ParseArgString(argc, argv, "--replay");
+
+		Replay replay;
+		if (pathReplay) {
+			replay.Load(pathReplay);
+			if (replay.GetSceneID() != SCENE_ID_EMITTER)
+				throw EngineError("The replay was recorded with a different scene.");
+			countFrame = replay.GetFrameCount();
+			seed = replay.GetSeed();
+		}
+		else if (pathRecord)
+			replay.Reset(SCENE_ID_EMITTER, seed);
+
+		JobSystem* jobSystem = nullptr;
+		if (countThread > 0U) {
+			jobSystem = new JobSystem();
+			jobSystem->Initialize(countThread - 1U);
+		}
+
+		Scene* scene = new Scene();
+		scene->SetSeed(seed);
+		for (size_t i = 0; i < countEmitter; ++i) {
+			float x = (float)(i % 16U) * 40.0f;
+			float y = (float)(i / 16U) * 40.0f;
+			scene->AddTask(TaskBase::Create<Emitter>(scene, x, y));
+		}
+
+		//Interval is the whole frame here, so GetFPS is the simulation rate
+		FrameStats frameStats(std::max<size_t>(std::min<size_t>(countFrame, 100000U), 1U));
+		if (pathCsv)
+			frameStats.SetDumpFile(pathCsv, 1000U);
+
+		printf("Running %u frames, %u emitters, %u threads, seed %llu%s\n",
+			(uint32_t)countFrame, (uint32_t)countEmitter, (uint32_t)countThread, (unsigned long long)seed,
+			pathReplay ? " (replay)" : (pathRecord ? " (recording)" : ""));
+
+		//Input for recordings: new buttons every half second
+		RandomGenerator randomInput(seed ^ 0x5eed5eed5eed5eedULL);
+		InputState input = { 0U };
+
+		SceneSnapshot snapshotHash;
+		const std::vector<Replay::Checkpoint>& listCheckpoint = replay.GetCheckpoints();
+		size_t indexCheckpoint = 0U;
+		size_t frameDesync = SIZE_MAX;
+
+		uint64_t countAllocStart = s_countAlloc.load();
+		uint64_t sizeAllocStart = s_sizeAlloc.load();
+		uint64_t timeTotalNs = 0U;
+		auto timePrev = stdch::steady_clock::now();
+		for (size_t i = 0; i < countFrame; ++i) {
+			if (pathReplay)
+				input = replay.GetInput(i);
+			else if (pathRecord && i % 30U == 0U) {
+				input.buttons = (uint32_t)randomInput.Next() & ~(1U << (uint32_t)VirtualKey::Pause);
+			}
+			scene->SetInput(input);
+			scene->Update();
+
+			auto timeNow = stdch::steady_clock::now();
+			uint64_t time = (uint64_t)stdch::duration_cast<stdch::nanoseconds>(timeNow - timePrev).count();
+			timeTotalNs += time;
+
+			FrameStats::Sample sample = { { time, 0U, 0U, time } };
+			frameStats.Record(sample);
+
+			//Hashing is kept out of the frame times
+			if (pathRecord && !pathReplay) {
+				replay.AddFrame(input);
+				if (scene->GetFrame() % Replay::CHECKPOINT_INTERVAL == 0U)
+					replay.AddCheckpoint(scene->GetFrame(), Replay::HashScene(scene, &snapshotHash));
+			}
+			else if (pathReplay && indexCheckpoint < listCheckpoint.size()
+				&& listCheckpoint[indexCheckpoint].frame == scene->GetFrame())
+			{
+				if (Replay::HashScene(scene, &snapshotHash) != listCheckpoint[indexCheckpoint].hash) {
+					frameDesync = scene->GetFrame();
+					break;
+				}
+				++indexCheckpoint;
+			}
+			timePrev = stdch::steady_clock::now();
+		}
+		double timeTotal = timeTotalNs / 1e9;
+		uint64_t countAlloc = s_countAlloc.load() - countAllocStart;
+		uint64_t sizeAlloc = s_sizeAlloc.load() - sizeAllocStart;
+
+		FrameStats::Summary summary = frameStats.GetSummary(FrameStats::Channel::Update);
+		printf("Total: %.3fs, %.1f fps (%.1fx realtime at 60fps), %u tasks at the end\n",
+			timeTotal, countFrame / timeTotal, countFrame / 60.0 / timeTotal, (uint32_t)scene->GetTaskCount());
+		printf("Frame (us): mean %.2f, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f\n",
+			summary.mean / 1e3, summary.p50 / 1e3, summary.p95 / 1e3, summary.p99 / 1e3, summary.max / 1e3);
+		printf("Allocations: %llu (%.2f per frame), %llu bytes\n",
+			(unsigned long long)countAlloc, countAlloc / (double)std::max<size_t>(countFrame, 1U),
+			(unsigned long long)sizeAlloc);
+		TaskBase::GetPool()->PrintStats("tasks");
+
+		int res = 0;
+		if (pathRecord && !pathReplay) {
+			replay.Save(pathRecord);
+			printf("Recorded %u frames, %u checkpoints to %s\n", (uint32_t)replay.GetFrameCount(),
+				(uint32_t)listCheckpoint.size(), pathRecord);
+		}
+		else if (pathReplay) {
+			if (frameDesync != SIZE_MAX) {
+				printf("Desync at frame %u\n", (uint32_t)frameDesync);
+				res = 1;
+			}
+			else
+				printf("Verified %u checkpoints\n", (uint32_t)indexCheckpoint);
+		}
+
+		ptr_delete(scene);
+		ptr_release(jobSystem);
+#ifdef __L_PROFILE
+		Profiler::ExportChromeTrace("profile.json");
+#endif
+		return res;
+	}
+	catch (EngineError& e) {
+		fprintf(stderr, "Engine Error: %s\n", e.what());
+	}
+	catch (std::exception& e) {
+		fprintf(stderr, "Unexpected Error: %s\n", e.what());
+	}
+	return 1;
+}
\ No newline at end of file
@@ -2,14 +2,31 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 
+//__L_HEADLESS: engine core only (scene, tasks, jobs), without Windows or DirectX.
+//	Used for the headless simulation runner, which also builds on Linux.
+
 //windows
 
+#ifndef __L_HEADLESS
 #define _WIN32_WINNT _WIN32_WINNT_WIN7		//Minimum support -> Windows 7
 #define WINVER _WIN32_WINNT
 
 #include <Windows.h>
 
 #pragma comment(lib, "winmm.lib")
+#else
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef uint32_t DWORD;
+typedef int32_t HRESULT;
+typedef DWORD D3DCOLOR;
+#endif
 
 //xmm
 
@@ -50,6 +67,8 @@
 
 #pragma warning(disable : 28251)	//Inconsistent annotation
 
+#ifndef __L_HEADLESS
+
 //DirectX
 
 //#define D3D_DEBUG_INFO
@@ -92,6 +111,8 @@
 
 #pragma comment(lib, "freetype.lib")
 
+#endif
+
 //Pointer utilities
 template<typename T> static constexpr inline void ptr_delete(T*& ptr) {
 	if (ptr) delete ptr;
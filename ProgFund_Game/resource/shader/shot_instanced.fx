@@ -0,0 +1,50 @@
+sampler g_sSampler : register(s0);
+
+float4x4 g_mProj : VIEWPROJECTION;
+float2 g_f2AtlasSize : ATLASSIZE;
+float4 g_vUVRect[250] : UVRECT;		//u0, v0, u1, v1 per graphic, ShotInstanceList::MAX_GRAPHIC
+
+//Stream 0 is a unit quad, stream 1 one ShotInstance per shot
+struct VS_INPUT {
+    float2 corner : POSITION0;		//0 or 1 on each axis
+    float2 position : TEXCOORD1;
+    float2 rotation : TEXCOORD2;	//cos, sin scaled by 32767
+    float2 graphic : TEXCOORD3;		//UV rect index, 8.8 fixed point scale
+    float4 diffuse : COLOR0;
+};
+struct PS_INPUT {
+    float4 position : POSITION;
+    float2 texUV : TEXCOORD0;
+	float4 diffuse : COLOR0;
+};
+
+PS_INPUT MainVS(VS_INPUT input) {
+    PS_INPUT output = (PS_INPUT)0;
+
+	float4 rect = g_vUVRect[(int)input.graphic.x];
+	float2 size = (rect.zw - rect.xy) * g_f2AtlasSize * (input.graphic.y / 256.0f);
+	float2 local = (input.corner - 0.5f) * size;
+	float2 rotation = input.rotation / 32767.0f;
+
+	//Half-pixel bias as in Sprite2D
+	float2 position = float2(local.x * rotation.x - local.y * rotation.y,
+		local.x * rotation.y + local.y * rotation.x) + input.position - 0.5f;
+
+    output.position = mul(float4(position, 1.0f, 1.0f), g_mProj);
+	output.position.z = 1.0f;
+    output.texUV = lerp(rect.xy, rect.zw, input.corner);
+    output.diffuse = input.diffuse;
+
+    return output;
+}
+
+float4 MainPS(PS_INPUT input) : COLOR0 {
+    return tex2D(g_sSampler, input.texUV) * input.diffuse;
+}
+
+technique Render {
+	pass P0 {
+		VertexShader = compile vs_3_0 MainVS();
+		PixelShader = compile ps_3_0 MainPS();
+	}
+}
\ No newline at end of file
@@ -5,6 +5,14 @@
 
 #define GET_INSTANCE(_type, _name) _type* _name = _type::GetBase();
 
+enum class BlendMode : uint8_t {
+	Alpha,
+	Add,
+	Subtract,
+	RevSubtract,
+	Invert,
+};
+
 class DxResourceManagerBase {
 public:
 	virtual ~DxResourceManagerBase() {}
@@ -28,12 +36,14 @@ public:
 		right = src.right;
 		bottom = src.bottom;
 	}
+#ifndef __L_HEADLESS
 	DxRect(const RECT& src) {
 		left = (T)src.left;
 		top = (T)src.top;
 		right = (T)src.right;
 		bottom = (T)src.bottom;
 	}
+#endif
 	template<typename L>
 	DxRect(const DxRect<L>& src) {
 		left = (T)src.left;
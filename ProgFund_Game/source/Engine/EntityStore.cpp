@@ -0,0 +1,216 @@
+#include "pch.h"
+#include "EntityStore.hpp"
+
+//*******************************************************************
+//ComponentType
+//*******************************************************************
+std::atomic<uint32_t> ComponentType::countID_ = 0U;
+
+uint32_t ComponentType::_NewID() {
+	uint32_t id = countID_.fetch_add(1U);
+	if (id >= MAX_COUNT)
+		throw EngineError(StringUtility::Format("ComponentType: More than %u component types.", (uint32_t)MAX_COUNT));
+	return id;
+}
+
+//*******************************************************************
+//Archetype
+//*******************************************************************
+static inline size_t _AlignColumn(size_t size) {
+	return (size + Archetype::COLUMN_ALIGNMENT - 1U) & ~(Archetype::COLUMN_ALIGNMENT - 1U);
+}
+
+Archetype::Archetype(TypeObject type, const std::vector<std::pair<uint32_t, uint32_t>>& listComponent) {
+	type_ = type;
+	mask_ = 0U;
+	memset(listColumnIndex_, 0xff, sizeof(listColumnIndex_));
+	count_ = 0U;
+
+	size_t sizeRow = sizeof(EntityHandle);
+	for (auto& [id, size] : listComponent) {
+		ComponentType::Mask bit = 1ULL << id;
+		if (mask_ & bit)
+			throw EngineError("Archetype: Component listed twice.");
+		mask_ |= bit;
+		listColumnIndex_[id] = (int8_t)listColumn_.size();
+		listColumn_.push_back(Column{ id, size, 0U });
+		sizeRow += size;
+	}
+
+	//Largest power of two whose aligned columns still fit in a chunk
+	size_t capacity = 1U;
+	while (capacity * 2U * sizeRow <= CHUNK_SIZE)
+		capacity *= 2U;
+	while (true) {
+		size_t sizeTotal = _AlignColumn(capacity * sizeof(EntityHandle));
+		for (Column& iColumn : listColumn_)
+			sizeTotal += _AlignColumn(capacity * iColumn.size);
+		if (sizeTotal <= CHUNK_SIZE) break;
+		if (capacity == 1U)
+			throw EngineError("Archetype: Components don't fit in a chunk.");
+		capacity /= 2U;
+	}
+	shiftChunk_ = 0U;
+	while (((size_t)1U << shiftChunk_) < capacity)
+		++shiftChunk_;
+
+	size_t offset = 0U;
+	offsetHandle_ = 0U;
+	offset += _AlignColumn(capacity * sizeof(EntityHandle));
+	for (Column& iColumn : listColumn_) {
+		iColumn.offset = (uint32_t)offset;
+		offset += _AlignColumn(capacity * iColumn.size);
+	}
+}
+Archetype::~Archetype() {
+	for (byte* iChunk : listChunk_)
+		::operator delete(iChunk, std::align_val_t(COLUMN_ALIGNMENT));
+}
+
+size_t Archetype::_AddRow(EntityHandle handle) {
+	size_t row = count_;
+	if ((row >> shiftChunk_) >= listChunk_.size()) {
+		byte* chunk = (byte*)::operator new(CHUNK_SIZE, std::align_val_t(COLUMN_ALIGNMENT));
+		memset(chunk, 0, CHUNK_SIZE);
+		listChunk_.push_back(chunk);
+	}
+	_GetHandleAt(row) = handle;
+	++count_;
+	return row;
+}
+EntityHandle Archetype::_RemoveRow(size_t row) {
+	size_t last = count_ - 1U;
+	EntityHandle handleMoved = INVALID_ENTITY;
+	if (row != last) {
+		for (Column& iColumn : listColumn_)
+			memcpy(_GetCell(row, iColumn), _GetCell(last, iColumn), iColumn.size);
+		handleMoved = _GetHandleAt(last);
+		_GetHandleAt(row) = handleMoved;
+	}
+
+	//Vacated rows go back to zero, new entities and snapshots rely on it
+	for (Column& iColumn : listColumn_)
+		memset(_GetCell(last, iColumn), 0, iColumn.size);
+	_GetHandleAt(last) = 0U;
+	--count_;
+	return handleMoved;
+}
+
+void Archetype::Serialize(SnapshotWriter* writer) {
+	writer->Write<uint64_t>(count_);
+	for (size_t iChunk = 0; iChunk < listChunk_.size(); ++iChunk) {
+		if (GetChunkSize(iChunk) == 0U) break;
+		writer->Write(listChunk_[iChunk], CHUNK_SIZE);
+	}
+}
+void Archetype::Restore(SnapshotReader* reader) {
+	size_t count = (size_t)reader->Read<uint64_t>();
+	size_t countChunk = (count + GetChunkMask()) >> shiftChunk_;
+
+	while (listChunk_.size() < countChunk) {
+		byte* chunk = (byte*)::operator new(CHUNK_SIZE, std::align_val_t(COLUMN_ALIGNMENT));
+		listChunk_.push_back(chunk);
+	}
+	for (size_t iChunk = 0; iChunk < listChunk_.size(); ++iChunk) {
+		if (iChunk < countChunk)
+			reader->Read(listChunk_[iChunk], CHUNK_SIZE);
+		else
+			memset(listChunk_[iChunk], 0, CHUNK_SIZE);
+	}
+	count_ = count;
+}
+
+//*******************************************************************
+//EntityStore
+//*******************************************************************
+EntityStore::EntityStore() {
+	depthIterate_ = 0U;
+}
+EntityStore::~EntityStore() {
+}
+
+void EntityStore::Clear() {
+	if (depthIterate_ > 0U)
+		throw EngineError("EntityStore: Can't clear while iterating.");
+	while (mapEntity_.GetSize() > 0U)
+		Destroy(mapEntity_.GetHandleAt(mapEntity_.GetSize() - 1U));
+	listDestroy_.clear();
+}
+
+size_t EntityStore::RegisterArchetype(TypeObject type, const std::vector<std::pair<uint32_t, uint32_t>>& listComponent) {
+	if (listArchetype_.size() >= 0xffffU)
+		throw EngineError("EntityStore: Too many archetypes.");
+	listArchetype_.push_back(std::make_unique<Archetype>(type, listComponent));
+	return listArchetype_.size() - 1U;
+}
+
+EntityHandle EntityStore::Create(size_t iArchetype) {
+	if (iArchetype >= listArchetype_.size())
+		throw EngineError(StringUtility::Format("EntityStore: Invalid archetype %u.", (uint32_t)iArchetype));
+	EntityHandle handle = mapEntity_.Allocate();
+	size_t row = listArchetype_[iArchetype]->_AddRow(handle);
+	mapEntity_.Assign(handle, _PackLocation(iArchetype, row));
+	return handle;
+}
+bool EntityStore::Destroy(EntityHandle handle) {
+	uint64_t* location = mapEntity_.Get(handle);
+	if (location == nullptr) return false;
+
+	size_t iArchetype = _GetArchetypeIndex(*location);
+	size_t row = _GetRow(*location);
+	EntityHandle handleMoved = listArchetype_[iArchetype]->_RemoveRow(row);
+	if (handleMoved != INVALID_ENTITY)
+		*mapEntity_.Get(handleMoved) = _PackLocation(iArchetype, row);
+	mapEntity_.Erase(handle);
+	return true;
+}
+void EntityStore::DestroyDeferred(EntityHandle handle) {
+	if (depthIterate_ > 0U)
+		listDestroy_.push_back(handle);
+	else
+		Destroy(handle);
+}
+void EntityStore::FlushDestroyed() {
+	//Stale or repeated handles are no-ops in Destroy
+	for (EntityHandle iHandle : listDestroy_)
+		Destroy(iHandle);
+	listDestroy_.clear();
+}
+
+TypeObject EntityStore::GetType(EntityHandle handle) {
+	uint64_t* location = mapEntity_.Get(handle);
+	return location ? listArchetype_[_GetArchetypeIndex(*location)]->GetType() : TypeObject::Null;
+}
+size_t EntityStore::GetArchetypeIndex(EntityHandle handle) {
+	uint64_t* location = mapEntity_.Get(handle);
+	return location ? _GetArchetypeIndex(*location) : SIZE_MAX;
+}
+
+//Archetypes have to be registered the same way before restoring
+void EntityStore::Serialize(SnapshotWriter* writer) {
+	writer->Write<uint32_t>((uint32_t)listArchetype_.size());
+	for (auto& iArchetype : listArchetype_)
+		writer->Write(iArchetype->GetMask());
+
+	listLocationScratch_.assign(mapEntity_.begin(), mapEntity_.end());
+	writer->WriteArray(listLocationScratch_);
+	mapEntity_.SerializeLayout(writer);
+	for (auto& iArchetype : listArchetype_)
+		iArchetype->Serialize(writer);
+}
+void EntityStore::Restore(SnapshotReader* reader) {
+	if (depthIterate_ > 0U)
+		throw EngineError("EntityStore: Can't restore while iterating.");
+	if (reader->Read<uint32_t>() != listArchetype_.size())
+		throw EngineError("EntityStore: Snapshot has a different archetype count.");
+	for (auto& iArchetype : listArchetype_) {
+		if (reader->Read<ComponentType::Mask>() != iArchetype->GetMask())
+			throw EngineError("EntityStore: Snapshot has different archetypes.");
+	}
+
+	reader->ReadArray(listLocationScratch_);
+	mapEntity_.RestoreLayout(reader, listLocationScratch_);
+	for (auto& iArchetype : listArchetype_)
+		iArchetype->Restore(reader);
+	listDestroy_.clear();
+}
\ No newline at end of file
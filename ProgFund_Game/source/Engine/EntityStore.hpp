@@ -0,0 +1,232 @@
+#pragma once
+#include "../../pch.h"
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+
+#include "SlotMap.hpp"
+#include "Snapshot.hpp"
+
+enum class TypeObject : uint8_t {
+	Null,
+	Render,
+	Sound,
+	Player,
+	Enemy,
+	Shot,
+	Item,
+};
+
+typedef SlotMap<uint64_t>::Handle EntityHandle;
+constexpr EntityHandle INVALID_ENTITY = SlotMap<uint64_t>::INVALID_HANDLE;
+
+//*******************************************************************
+//ComponentType
+//	Process-wide ID per component struct, handed out on first use.
+//	Components are plain data: they're moved with memcpy and snapshotted as bytes.
+//*******************************************************************
+class ComponentType {
+public:
+	static constexpr size_t MAX_COUNT = 64U;
+	typedef uint64_t Mask;
+private:
+	static std::atomic<uint32_t> countID_;
+
+	static uint32_t _NewID();
+public:
+	template<typename T>
+	static uint32_t GetID() {
+		static_assert(std::is_trivially_copyable_v<T>, "Components must be trivially copyable.");
+		static const uint32_t id = _NewID();
+		return id;
+	}
+	template<typename... T>
+	static Mask GetMask() { return ((1ULL << GetID<T>()) | ... | 0ULL); }
+};
+
+//*******************************************************************
+//Archetype
+//	All entities with the same component set, stored in fixed-size chunks.
+//	Inside a chunk every component is its own array, so a system walking
+//	one or two components reads only those, front to back.
+//*******************************************************************
+class Archetype {
+	friend class EntityStore;
+public:
+	static constexpr size_t CHUNK_SIZE = 0x4000U;		//16 KiB
+	static constexpr size_t COLUMN_ALIGNMENT = 64U;
+
+	struct Column {
+		uint32_t id;
+		uint32_t size;
+		uint32_t offset;	//From the chunk start
+	};
+private:
+	TypeObject type_;
+	ComponentType::Mask mask_;
+	std::vector<Column> listColumn_;
+	int8_t listColumnIndex_[ComponentType::MAX_COUNT];	//Component ID -> column, -1 if absent
+
+	uint32_t shiftChunk_;		//Chunk capacity is a power of two so a row splits with a shift
+	uint32_t offsetHandle_;		//Each row also keeps its entity's handle, to fix it up on moves
+	std::vector<byte*> listChunk_;
+	size_t count_;
+
+	inline byte* _GetCell(size_t row, const Column& column) {
+		return listChunk_[row >> shiftChunk_] + column.offset + (row & GetChunkMask()) * column.size;
+	}
+	EntityHandle& _GetHandleAt(size_t row) {
+		return ((EntityHandle*)(listChunk_[row >> shiftChunk_] + offsetHandle_))[row & GetChunkMask()];
+	}
+
+	size_t _AddRow(EntityHandle handle);
+	//Moves the last row into the hole; returns the handle that now sits at row, or INVALID_ENTITY
+	EntityHandle _RemoveRow(size_t row);
+public:
+	Archetype(TypeObject type, const std::vector<std::pair<uint32_t, uint32_t>>& listComponent);
+	~Archetype();
+
+	TypeObject GetType() { return type_; }
+	ComponentType::Mask GetMask() { return mask_; }
+	bool HasComponents(ComponentType::Mask mask) { return (mask_ & mask) == mask; }
+
+	size_t GetSize() { return count_; }
+	size_t GetChunkCapacity() { return (size_t)1U << shiftChunk_; }
+	size_t GetChunkMask() { return GetChunkCapacity() - 1U; }
+	size_t GetChunkCount() { return listChunk_.size(); }
+	size_t GetChunkSize(size_t iChunk) {
+		size_t begin = iChunk << shiftChunk_;
+		return begin < count_ ? std::min(count_ - begin, GetChunkCapacity()) : 0U;
+	}
+
+	//Start of a component's array in a chunk, nullptr if the archetype lacks it
+	template<typename T>
+	T* GetColumn(size_t iChunk) {
+		int8_t iColumn = listColumnIndex_[ComponentType::GetID<T>()];
+		if (iColumn < 0) return nullptr;
+		return (T*)(listChunk_[iChunk] + listColumn_[iColumn].offset);
+	}
+	EntityHandle* GetHandles(size_t iChunk) { return (EntityHandle*)(listChunk_[iChunk] + offsetHandle_); }
+
+	void Serialize(SnapshotWriter* writer);
+	void Restore(SnapshotReader* reader);
+};
+
+//*******************************************************************
+//EntityStore
+//	Archetype-sorted entity storage addressed through generation-checked
+//	handles. Rows move when entities are destroyed; handles don't.
+//*******************************************************************
+class EntityStore {
+private:
+	//Slot value: [archetype:16][row:48]
+	SlotMap<uint64_t> mapEntity_;
+	std::vector<std::unique_ptr<Archetype>> listArchetype_;
+
+	std::vector<EntityHandle> listDestroy_;
+	size_t depthIterate_;
+
+	std::vector<uint64_t> listLocationScratch_;
+
+	static inline uint64_t _PackLocation(size_t iArchetype, size_t row) { return ((uint64_t)iArchetype << 48) | row; }
+	static inline size_t _GetArchetypeIndex(uint64_t location) { return (size_t)(location >> 48); }
+	static inline size_t _GetRow(uint64_t location) { return (size_t)(location & 0xffffffffffffULL); }
+public:
+	EntityStore();
+	~EntityStore();
+
+	void Clear();
+
+	template<typename... T>
+	size_t RegisterArchetype(TypeObject type) {
+		return RegisterArchetype(type, { std::make_pair(ComponentType::GetID<T>(), (uint32_t)sizeof(T))... });
+	}
+	size_t RegisterArchetype(TypeObject type, const std::vector<std::pair<uint32_t, uint32_t>>& listComponent);
+	Archetype* GetArchetype(size_t index) { return listArchetype_[index].get(); }
+	size_t GetArchetypeCount() { return listArchetype_.size(); }
+
+	//Components start zeroed
+	EntityHandle Create(size_t iArchetype);
+	bool Destroy(EntityHandle handle);
+	//Destroys once the outermost ForEach returns, or right away outside of one
+	void DestroyDeferred(EntityHandle handle);
+
+	bool IsValid(EntityHandle handle) { return mapEntity_.IsValid(handle); }
+	size_t GetSize() { return mapEntity_.GetSize(); }
+
+	TypeObject GetType(EntityHandle handle);
+	size_t GetArchetypeIndex(EntityHandle handle);
+
+	//nullptr for stale handles and components the entity doesn't have
+	template<typename T>
+	T* Get(EntityHandle handle) {
+		uint64_t* location = mapEntity_.Get(handle);
+		if (location == nullptr) return nullptr;
+		Archetype* archetype = listArchetype_[_GetArchetypeIndex(*location)].get();
+		int8_t iColumn = archetype->listColumnIndex_[ComponentType::GetID<T>()];
+		if (iColumn < 0) return nullptr;
+		return (T*)archetype->_GetCell(_GetRow(*location), archetype->listColumn_[iColumn]);
+	}
+
+	//func(size_t count, EntityHandle* handles, T*... columns) once per chunk of every
+	//	archetype that has all of T. Destroy through DestroyDeferred inside, as Destroy moves rows;
+	//	entities created inside may or may not be visited.
+	template<typename... T, typename F>
+	void ForEachChunk(F&& func) {
+		ComponentType::Mask mask = ComponentType::GetMask<T...>();
+		++depthIterate_;
+		try {
+			for (auto& iArchetype : listArchetype_) {
+				if (!iArchetype->HasComponents(mask)) continue;
+				for (size_t iChunk = 0; iChunk < iArchetype->GetChunkCount(); ++iChunk) {
+					size_t count = iArchetype->GetChunkSize(iChunk);
+					if (count > 0U)
+						func(count, iArchetype->GetHandles(iChunk), iArchetype->template GetColumn<T>(iChunk)...);
+				}
+			}
+		}
+		catch (...) {
+			--depthIterate_;
+			throw;
+		}
+		if (--depthIterate_ == 0U)
+			FlushDestroyed();
+	}
+	//func(EntityHandle, T&...) per entity
+	template<typename... T, typename F>
+	void ForEach(F&& func) {
+		ForEachChunk<T...>([&](size_t count, EntityHandle* handles, T*... columns) {
+			for (size_t i = 0; i < count; ++i)
+				func(handles[i], columns[i]...);
+		});
+	}
+	void FlushDestroyed();
+
+	void Serialize(SnapshotWriter* writer);
+	void Restore(SnapshotReader* reader);
+};
+
+//*******************************************************************
+//EntityRef
+//	ObjectBase-style view of one entity for gameplay code that works on
+//	single objects. Holds no reference; check IsDeleted before use.
+//*******************************************************************
+class EntityRef {
+private:
+	EntityStore* store_;
+	EntityHandle handle_;
+public:
+	EntityRef() : store_(nullptr), handle_(INVALID_ENTITY) {}
+	EntityRef(EntityStore* store, EntityHandle handle) : store_(store), handle_(handle) {}
+
+	EntityHandle GetHandle() { return handle_; }
+	TypeObject GetType() { return store_ ? store_->GetType(handle_) : TypeObject::Null; }
+	bool IsDeleted() { return store_ == nullptr || !store_->IsValid(handle_); }
+	void Delete() {
+		if (store_) store_->DestroyDeferred(handle_);
+	}
+
+	template<typename T>
+	T* Get() { return store_ ? store_->Get<T>(handle_) : nullptr; }
+};
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "pch.h"
+#include "FixedTimestep.hpp"
+#include "Utility.hpp"
+
+//*******************************************************************
+//FixedTimestep
+//*******************************************************************
+FixedTimestep::FixedTimestep(uint64_t rate, size_t maxCatchUp) {
+	if (rate == 0U)
+		throw EngineError("FixedTimestep: Rate must be above 0.");
+	rate_ = rate;
+	maxCatchUp_ = std::max<size_t>(maxCatchUp, 1U);
+	Reset();
+}
+
+void FixedTimestep::Reset() {
+	Reset(Clock::now());
+}
+void FixedTimestep::Reset(Clock::time_point time) {
+	timePrevious_ = time;
+	accum_ = 0U;
+	totalStep_ = 0U;
+	totalDropped_ = 0U;
+}
+
+size_t FixedTimestep::Advance() {
+	return Advance(Clock::now());
+}
+size_t FixedTimestep::Advance(Clock::time_point time) {
+	int64_t delta = stdch::duration_cast<stdch::nanoseconds>(time - timePrevious_).count();
+	timePrevious_ = time;
+	if (delta <= 0) return 0U;
+
+	//A very long stall (debugger, window drag) would only be dropped anyway
+	uint64_t deltaMax = (maxCatchUp_ + 1U) * NS_PER_SECOND / rate_;
+	uint64_t deltaDropped = 0U;
+	if ((uint64_t)delta > deltaMax) {
+		deltaDropped = (uint64_t)delta - deltaMax;
+		delta = (int64_t)deltaMax;
+	}
+
+	accum_ += (uint64_t)delta * rate_;
+	uint64_t countStep = accum_ / NS_PER_SECOND;
+	accum_ -= countStep * NS_PER_SECOND;
+	totalDropped_ += deltaDropped * rate_ / NS_PER_SECOND;
+
+	if (countStep > maxCatchUp_) {
+		totalDropped_ += countStep - maxCatchUp_;
+		countStep = maxCatchUp_;
+	}
+	totalStep_ += countStep;
+	return (size_t)countStep;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include "../../pch.h"
+
+//*******************************************************************
+//FixedTimestep
+//	Turns elapsed steady_clock time into a whole number of fixed updates.
+//	Time is accumulated as nanoseconds * rate so steps never drift, even
+//	when 1s / rate isn't a whole number of nanoseconds.
+//*******************************************************************
+class FixedTimestep {
+public:
+	typedef stdch::steady_clock Clock;
+private:
+	static constexpr uint64_t NS_PER_SECOND = 1000000000ULL;
+
+	uint64_t rate_;
+	size_t maxCatchUp_;
+
+	Clock::time_point timePrevious_;
+	uint64_t accum_;		//In ns * rate_, one step is NS_PER_SECOND
+
+	uint64_t totalStep_;
+	uint64_t totalDropped_;
+public:
+	//maxCatchUp: most updates Advance may return, time beyond that is dropped
+	FixedTimestep(uint64_t rate = 60U, size_t maxCatchUp = 5U);
+
+	//Restarts from now with an empty accumulator
+	void Reset();
+	void Reset(Clock::time_point time);
+
+	//Adds the time since the last call and returns how many updates are due
+	size_t Advance();
+	size_t Advance(Clock::time_point time);
+
+	//Fraction of a step accumulated past the last update, in [0, 1)
+	double GetAlpha() { return accum_ / (double)NS_PER_SECOND; }
+	//Time until the next update is due
+	uint64_t GetTimeToNextStep() { return (NS_PER_SECOND - accum_ + rate_ - 1U) / rate_; }
+
+	uint64_t GetRate() { return rate_; }
+	double GetStepTime() { return NS_PER_SECOND / (double)rate_; }
+	Clock::time_point GetPreviousTime() { return timePrevious_; }
+
+	uint64_t GetTotalStepCount() { return totalStep_; }
+	//Updates skipped because of the catch-up cap
+	uint64_t GetTotalDroppedCount() { return totalDropped_; }
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "FramePacer.hpp"
+#include "Utility.hpp"
+
+#include <thread>
+#ifndef _WIN32
+#include <time.h>
+#include <cerrno>
+#endif
+
+static constexpr uint64_t NS_PER_SECOND = 1000000000ULL;
+static constexpr uint64_t NS_PER_MS = 1000000ULL;
+
+//Remaining time under which spinning stops yielding the thread
+static constexpr uint64_t SPIN_YIELD_THRESHOLD = 200000ULL;
+//Bounds on the sleep margin, so one bad sleep can't turn the pacer into a spin loop
+static constexpr double MARGIN_MAX = 4.0 * NS_PER_MS;
+
+//*******************************************************************
+//FramePacer
+//*******************************************************************
+FramePacer::FramePacer(uint64_t rate) {
+	SetRate(rate);
+	bStarted_ = false;
+
+#ifdef _WIN32
+	timeBeginPeriod(1);
+	errorMean_ = 1.0 * NS_PER_MS;
+#else
+	errorMean_ = 0.1 * NS_PER_MS;
+#endif
+	errorVariance_ = 0.0;
+
+	ResetJitter();
+}
+FramePacer::~FramePacer() {
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::SetRate(uint64_t rate) {
+	if (rate == 0U)
+		throw EngineError("FramePacer: Rate must be above 0.");
+	interval_ = NS_PER_SECOND / rate;
+}
+
+void FramePacer::_Sleep(uint64_t time) {
+#ifdef _WIN32
+	Sleep((DWORD)(time / NS_PER_MS));
+#else
+	timespec req;
+	req.tv_sec = (time_t)(time / NS_PER_SECOND);
+	req.tv_nsec = (long)(time % NS_PER_SECOND);
+	while (clock_nanosleep(CLOCK_MONOTONIC, 0, &req, &req) == EINTR) {}
+#endif
+}
+void FramePacer::_UpdateCalibration(uint64_t error) {
+	//Roughly the last 16 sleeps
+	constexpr double WEIGHT = 1.0 / 16.0;
+	double diff = (double)error - errorMean_;
+	errorMean_ += diff * WEIGHT;
+	errorVariance_ = (1.0 - WEIGHT) * (errorVariance_ + diff * diff * WEIGHT);
+}
+uint64_t FramePacer::GetSleepMargin() {
+	double margin = errorMean_ + 2.0 * sqrt(errorVariance_);
+	return (uint64_t)std::clamp(margin, 0.0, MARGIN_MAX);
+}
+
+void FramePacer::Wait() {
+	Clock::time_point now = Clock::now();
+	if (!bStarted_) {
+		bStarted_ = true;
+		timePrevious_ = now;
+		timeDeadline_ = now + stdch::nanoseconds(interval_);
+		return;
+	}
+
+	//Coarse sleeps, re-estimating the margin after each
+	while (true) {
+		int64_t remain = stdch::duration_cast<stdch::nanoseconds>(timeDeadline_ - now).count();
+		int64_t timeSleep = remain - (int64_t)GetSleepMargin();
+#ifdef _WIN32
+		if (timeSleep < (int64_t)NS_PER_MS) break;
+		timeSleep -= timeSleep % NS_PER_MS;
+#else
+		if (timeSleep <= 0) break;
+#endif
+		_Sleep((uint64_t)timeSleep);
+
+		Clock::time_point after = Clock::now();
+		int64_t slept = stdch::duration_cast<stdch::nanoseconds>(after - now).count();
+		_UpdateCalibration((uint64_t)std::max<int64_t>(slept - timeSleep, 0));
+		now = after;
+	}
+
+	while (now < timeDeadline_) {
+		if (timeDeadline_ - now > stdch::nanoseconds(SPIN_YIELD_THRESHOLD))
+			std::this_thread::yield();
+		else
+			_mm_pause();
+		now = Clock::now();
+	}
+
+	_RecordInterval((uint64_t)stdch::duration_cast<stdch::nanoseconds>(now - timePrevious_).count());
+	timePrevious_ = now;
+
+	timeDeadline_ += stdch::nanoseconds(interval_);
+	if (timeDeadline_ <= now)
+		timeDeadline_ = now + stdch::nanoseconds(interval_);
+}
+
+void FramePacer::_RecordInterval(uint64_t interval) {
+	//Welford's, the squared sums of ns intervals would lose the variance
+	++countInterval_;
+	double diff = (double)interval - meanInterval_;
+	meanInterval_ += diff / countInterval_;
+	m2Interval_ += diff * ((double)interval - meanInterval_);
+	uint64_t error = interval > interval_ ? interval - interval_ : interval_ - interval;
+	maxError_ = std::max(maxError_, error);
+}
+FramePacer::Jitter FramePacer::GetJitter() {
+	Jitter res = { countInterval_, 0.0, 0.0, maxError_ };
+	if (countInterval_ > 0U) {
+		res.mean = meanInterval_;
+		res.deviation = sqrt(m2Interval_ / countInterval_);
+	}
+	return res;
+}
+void FramePacer::ResetJitter() {
+	countInterval_ = 0U;
+	meanInterval_ = 0.0;
+	m2Interval_ = 0.0;
+	maxError_ = 0U;
+}
\ No newline at end of file
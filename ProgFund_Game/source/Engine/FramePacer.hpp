@@ -0,0 +1,55 @@
+#pragma once
+#include "../../pch.h"
+
+//*******************************************************************
+//FramePacer
+//	Waits out each frame's deadline by sleeping until close to it, then
+//	spinning for the rest. How early to stop sleeping is learned from how
+//	far past their request previous sleeps ran.
+//*******************************************************************
+class FramePacer {
+public:
+	typedef stdch::steady_clock Clock;
+
+	struct Jitter {
+		size_t count;
+		double mean;		//Achieved interval, in ns
+		double deviation;	//Standard deviation of the interval
+		uint64_t maxError;	//Largest |interval - target|
+	};
+private:
+	uint64_t interval_;
+	Clock::time_point timeDeadline_;
+	Clock::time_point timePrevious_;
+	bool bStarted_;
+
+	//Sleep overshoot estimate, exponential moving average
+	double errorMean_;
+	double errorVariance_;
+
+	//Interval statistics since the last ResetJitter
+	size_t countInterval_;
+	double meanInterval_;
+	double m2Interval_;
+	uint64_t maxError_;
+
+	void _Sleep(uint64_t time);
+	void _UpdateCalibration(uint64_t error);
+	void _RecordInterval(uint64_t interval);
+public:
+	FramePacer(uint64_t rate = 60U);
+	~FramePacer();
+
+	void SetRate(uint64_t rate);
+	uint64_t GetInterval() { return interval_; }
+
+	//Blocks until the next frame's deadline. Falling a whole interval
+	//	behind restarts the schedule from now instead of rushing to catch up.
+	void Wait();
+
+	//Time before a deadline at which sleeping stops
+	uint64_t GetSleepMargin();
+
+	Jitter GetJitter();
+	void ResetJitter();
+};
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "FrameStats.hpp"
+#include "Utility.hpp"
+
+//*******************************************************************
+//FrameStats
+//*******************************************************************
+FrameStats::FrameStats(size_t capacity) {
+	if (capacity == 0U) capacity = 1U;
+	listSample_.resize(capacity);
+	listSort_.resize(capacity);
+
+	budget_ = 1000000000ULL / 60U;
+	frameDumpInterval_ = 0U;
+	Clear();
+}
+FrameStats::~FrameStats() {
+	if (streamDump_.is_open())
+		streamDump_.close();
+}
+
+static inline uint64_t _GetBusyTime(const FrameStats::Sample& sample) {
+	return sample.time[(size_t)FrameStats::Channel::Update]
+		+ sample.time[(size_t)FrameStats::Channel::Render]
+		+ sample.time[(size_t)FrameStats::Channel::Present];
+}
+
+void FrameStats::Record(const Sample& sample) {
+	listSample_[head_] = sample;
+	head_ = (head_ + 1U) % listSample_.size();
+	if (count_ < listSample_.size()) ++count_;
+
+	++totalFrame_;
+	if (_GetBusyTime(sample) > budget_)
+		++totalHitch_;
+
+	if (frameDumpInterval_ > 0U && (totalFrame_ % frameDumpInterval_) == 0U)
+		Dump();
+}
+void FrameStats::Clear() {
+	head_ = 0U;
+	count_ = 0U;
+	totalFrame_ = 0U;
+	totalHitch_ = 0U;
+}
+
+void FrameStats::SetDumpFile(const std::string& path, uint64_t frameInterval) {
+	if (streamDump_.is_open())
+		streamDump_.close();
+	frameDumpInterval_ = 0U;
+
+	streamDump_.open(path, std::ios::out | std::ios::trunc);
+	if (!streamDump_.is_open())
+		throw EngineError(StringUtility::Format("FrameStats: Failed to open %s for writing.", path.c_str()));
+
+	streamDump_ << "frame,hitch";
+	for (const char* iChannel : { "update", "render", "present", "interval" }) {
+		for (const char* iStat : { "mean", "p50", "p95", "p99", "max" })
+			streamDump_ << ',' << iChannel << '_' << iStat;
+	}
+	streamDump_ << '\n';
+	frameDumpInterval_ = frameInterval;
+}
+void FrameStats::Dump() {
+	if (!streamDump_.is_open()) return;
+
+	streamDump_ << totalFrame_ << ',' << GetHitchCount();
+	for (size_t i = 0; i < CHANNEL_COUNT; ++i) {
+		Summary summary = GetSummary((Channel)i);
+		streamDump_ << ',' << summary.mean << ',' << summary.p50 << ',' << summary.p95
+			<< ',' << summary.p99 << ',' << summary.max;
+	}
+	streamDump_ << '\n';
+	streamDump_.flush();
+}
+
+FrameStats::Summary FrameStats::GetSummary(Channel channel) {
+	Summary res = { 0U, 0U, 0U, 0U, 0U };
+	if (count_ == 0U) return res;
+
+	uint64_t sum = 0U;
+	for (size_t i = 0; i < count_; ++i) {
+		uint64_t time = listSample_[i].time[(size_t)channel];
+		listSort_[i] = time;
+		sum += time;
+	}
+	res.mean = sum / count_;
+
+	//Nearest-rank; each nth_element only has to partition what's above the previous one
+	auto itrBegin = listSort_.begin();
+	auto itrEnd = listSort_.begin() + count_;
+	auto Percentile = [&](size_t pct) -> uint64_t {
+		size_t rank = (count_ * pct + 99U) / 100U;
+		auto itrNth = listSort_.begin() + (rank > 0U ? rank - 1U : 0U);
+		std::nth_element(itrBegin, itrNth, itrEnd);
+		itrBegin = itrNth;
+		return *itrNth;
+	};
+	res.p50 = Percentile(50U);
+	res.p95 = Percentile(95U);
+	res.p99 = Percentile(99U);
+	res.max = *std::max_element(itrBegin, itrEnd);
+	return res;
+}
+size_t FrameStats::GetHitchCount() {
+	size_t res = 0U;
+	for (size_t i = 0; i < count_; ++i) {
+		if (_GetBusyTime(listSample_[i]) > budget_)
+			++res;
+	}
+	return res;
+}
+
+double FrameStats::GetFPS(size_t countRecent) {
+	size_t count = std::min(countRecent, count_);
+	size_t capacity = listSample_.size();
+
+	uint64_t sum = 0U;
+	for (size_t i = 1; i <= count; ++i)
+		sum += listSample_[(head_ + capacity - i) % capacity].time[(size_t)Channel::Interval];
+	return sum > 0U ? (count * 1000000000.0) / (double)sum : 0.0;
+}
\ No newline at end of file
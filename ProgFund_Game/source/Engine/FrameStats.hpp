@@ -0,0 +1,65 @@
+#pragma once
+#include "../../pch.h"
+
+//*******************************************************************
+//FrameStats
+//	Fixed ring of the last frames' timings, all in nanoseconds. Nothing is
+//	allocated after construction, including for percentile queries.
+//*******************************************************************
+class FrameStats {
+public:
+	enum class Channel : uint8_t {
+		Update,
+		Render,
+		Present,
+		Interval,	//Start of the previous frame to the start of this one
+	};
+	static constexpr size_t CHANNEL_COUNT = 4U;
+
+	struct Sample {
+		uint64_t time[CHANNEL_COUNT];
+	};
+	struct Summary {
+		uint64_t mean;
+		uint64_t p50;
+		uint64_t p95;
+		uint64_t p99;
+		uint64_t max;
+	};
+private:
+	std::vector<Sample> listSample_;
+	std::vector<uint64_t> listSort_;	//Scratch for percentiles
+	size_t head_;
+	size_t count_;
+
+	uint64_t totalFrame_;
+	uint64_t budget_;
+	uint64_t totalHitch_;
+
+	std::ofstream streamDump_;
+	uint64_t frameDumpInterval_;
+public:
+	FrameStats(size_t capacity = 600U);
+	~FrameStats();
+
+	void Record(const Sample& sample);
+	void Clear();
+
+	//Frames whose update + render + present exceed this count as hitches
+	void SetBudget(uint64_t budget) { budget_ = budget; }
+	uint64_t GetBudget() { return budget_; }
+
+	//Appends a CSV row of the window's summaries every interval frames
+	void SetDumpFile(const std::string& path, uint64_t frameInterval);
+	void Dump();
+
+	Summary GetSummary(Channel channel);
+	size_t GetHitchCount();		//In the current window
+	uint64_t GetTotalHitchCount() { return totalHitch_; }
+	uint64_t GetTotalFrameCount() { return totalFrame_; }
+	size_t GetCount() { return count_; }
+	size_t GetCapacity() { return listSample_.size(); }
+
+	//Mean rate over the newest frames, from their intervals
+	double GetFPS(size_t countRecent = SIZE_MAX);
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include "../../pch.h"
+
+enum class VirtualKey : uint8_t {
+	Left,
+	Right,
+	Up,
+	Down,
+	Shot,
+	Bomb,
+	Slow,
+	Pause,
+};
+
+//*******************************************************************
+//InputState
+//	Buttons held during one simulation frame. The simulation reads the
+//	player only through this, so a run can be replayed from its inputs.
+//*******************************************************************
+struct InputState {
+	uint32_t buttons;
+
+	bool IsHeld(VirtualKey key) const { return (buttons >> (uint32_t)key) & 1U; }
+	void SetHeld(VirtualKey key, bool bHeld) {
+		uint32_t mask = 1U << (uint32_t)key;
+		buttons = bHeld ? (buttons | mask) : (buttons & ~mask);
+	}
+
+	bool operator==(const InputState& other) const { return buttons == other.buttons; }
+	bool operator!=(const InputState& other) const { return buttons != other.buttons; }
+};
\ No newline at end of file
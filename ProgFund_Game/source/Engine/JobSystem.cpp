@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "Utility.hpp"
+#include "JobSystem.hpp"
+
+static thread_local size_t s_threadIndex = 0U;
+
+//*******************************************************************
+//JobSystem
+//*******************************************************************
+JobSystem* JobSystem::base_ = nullptr;
+JobSystem::JobSystem() {
+	wakeCount_ = 0U;
+	bStop_ = false;
+	func_ = nullptr;
+	count_ = 0U;
+	grain_ = 1U;
+	countPending_ = 0U;
+	pError_ = nullptr;
+}
+JobSystem::~JobSystem() {
+	Release();
+}
+void JobSystem::Initialize(size_t countWorker) {
+	if (base_) throw EngineError("JobSystem already initialized.");
+	base_ = this;
+
+	if (countWorker == 0U) {
+		size_t countHw = std::thread::hardware_concurrency();
+		countWorker = countHw > 1U ? countHw - 1U : 0U;
+	}
+
+	for (size_t i = 0; i <= countWorker; ++i) {
+		listQueue_.push_back(std::make_unique<WorkQueue>());
+		listQueue_.back()->range.store(0U, std::memory_order_relaxed);
+	}
+	for (size_t i = 1; i <= countWorker; ++i)
+		listThread_.push_back(std::thread(&JobSystem::_WorkerProc, this, i));
+}
+void JobSystem::Release() {
+	{
+		std::lock_guard<std::mutex> lock(lockWake_);
+		bStop_ = true;
+	}
+	cvWake_.notify_all();
+	for (std::thread& iThread : listThread_) {
+		if (iThread.joinable())
+			iThread.join();
+	}
+	listThread_.clear();
+	listQueue_.clear();
+
+	if (base_ == this) base_ = nullptr;
+}
+
+size_t JobSystem::GetThreadIndex() {
+	return s_threadIndex;
+}
+
+void JobSystem::_WorkerProc(size_t index) {
+	s_threadIndex = index;
+
+	size_t wakeLast = 0U;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(lockWake_);
+			cvWake_.wait(lock, [&]() { return bStop_ || wakeCount_ != wakeLast; });
+			if (bStop_) return;
+			wakeLast = wakeCount_;
+		}
+
+		size_t chunk;
+		while (countPending_.load(std::memory_order_acquire) > 0U) {
+			if (_PopJob(index, &chunk))
+				_RunJob(chunk);
+			else
+				std::this_thread::yield();
+		}
+	}
+}
+bool JobSystem::_PopJob(size_t index, size_t* pChunk) {
+	//A range only changes by being claimed from or by the next ParallelFor replacing it,
+	//	so a successful exchange always takes a chunk of the current call
+	WorkQueue* own = listQueue_[index].get();
+	uint64_t range = own->range.load(std::memory_order_acquire);
+	while ((uint32_t)range < (uint32_t)(range >> 32)) {
+		if (own->range.compare_exchange_weak(range, range + 1U, std::memory_order_acq_rel, std::memory_order_acquire)) {
+			*pChunk = (uint32_t)range;
+			return true;
+		}
+	}
+
+	size_t countQueue = listQueue_.size();
+	for (size_t i = 1; i < countQueue; ++i) {
+		WorkQueue* victim = listQueue_[(index + i) % countQueue].get();
+		range = victim->range.load(std::memory_order_acquire);
+		while ((uint32_t)range < (uint32_t)(range >> 32)) {
+			if (victim->range.compare_exchange_weak(range, range - (1ULL << 32), std::memory_order_acq_rel, std::memory_order_acquire)) {
+				*pChunk = (uint32_t)(range >> 32) - 1U;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+void JobSystem::_RunJob(size_t chunk) {
+	size_t begin = chunk * grain_;
+	try {
+		(*func_)(begin, std::min(count_, begin + grain_));
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(lockError_);
+		if (pError_ == nullptr)
+			pError_ = std::current_exception();
+	}
+	countPending_.fetch_sub(1U, std::memory_order_acq_rel);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const RangeFunction& func) {
+	if (count == 0U) return;
+	if (grain == 0U) grain = 1U;
+
+	size_t countQueue = listQueue_.size();
+	if (countQueue <= 1U || count <= grain) {
+		func(0U, count);
+		return;
+	}
+
+	//Every queue starts with an equal, contiguous share of the chunks
+	size_t countJob = (count + grain - 1U) / grain;
+	if (countJob > UINT32_MAX) throw EngineError("JobSystem: Too many chunks.");
+	func_ = &func;
+	count_ = count;
+	grain_ = grain;
+	countPending_.store(countJob, std::memory_order_release);
+	for (size_t iQueue = 0; iQueue < countQueue; ++iQueue) {
+		uint64_t begin = countJob * iQueue / countQueue;
+		uint64_t end = countJob * (iQueue + 1U) / countQueue;
+		listQueue_[iQueue]->range.store(begin | (end << 32), std::memory_order_release);
+	}
+	{
+		std::lock_guard<std::mutex> lock(lockWake_);
+		++wakeCount_;
+	}
+	cvWake_.notify_all();
+
+	size_t chunk;
+	while (countPending_.load(std::memory_order_acquire) > 0U) {
+		if (_PopJob(0U, &chunk))
+			_RunJob(chunk);
+		else
+			std::this_thread::yield();
+	}
+
+	if (pError_) {
+		std::exception_ptr pError = pError_;
+		pError_ = nullptr;
+		std::rethrow_exception(pError);
+	}
+}
\ No newline at end of file
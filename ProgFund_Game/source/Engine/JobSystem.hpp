@@ -0,0 +1,65 @@
+#pragma once
+#include "../../pch.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+//*******************************************************************
+//JobSystem
+//	Fixed pool of worker threads. ParallelFor deals each thread a contiguous
+//	range of chunks; a thread takes chunks from the front of its own range
+//	and steals from the back of the others' when it runs dry. Ranges are
+//	claimed by compare-and-swap, so dispatching neither locks nor allocates.
+//*******************************************************************
+class JobSystem {
+	static JobSystem* base_;
+public:
+	typedef std::function<void(size_t, size_t)> RangeFunction;
+private:
+	//Chunks [begin, end) not taken yet, packed as begin | end << 32; one cache line each
+	struct alignas(64) WorkQueue {
+		std::atomic<uint64_t> range;
+	};
+
+	std::vector<std::thread> listThread_;
+	std::vector<std::unique_ptr<WorkQueue>> listQueue_;	//[0] belongs to the owner thread
+
+	std::mutex lockWake_;
+	std::condition_variable cvWake_;
+	size_t wakeCount_;
+	bool bStop_;
+
+	//The current ParallelFor, published to the workers by the range stores
+	const RangeFunction* func_;
+	size_t count_;
+	size_t grain_;
+
+	std::atomic<size_t> countPending_;
+	std::mutex lockError_;
+	std::exception_ptr pError_;
+
+	void _WorkerProc(size_t index);
+	bool _PopJob(size_t index, size_t* pChunk);
+	void _RunJob(size_t chunk);
+public:
+	JobSystem();
+	~JobSystem();
+
+	static JobSystem* const GetBase() { return base_; }
+
+	//countWorker: 0 -> hardware concurrency - 1
+	void Initialize(size_t countWorker = 0U);
+	void Release();
+
+	//Includes the owner thread
+	size_t GetThreadCount() { return listQueue_.size(); }
+	//0 for the owner thread and any thread not managed by the pool
+	static size_t GetThreadIndex();
+
+	//Calls func over [0, count) in chunks of at most grain and blocks until all are done.
+	//	Only the owner thread may call this; the calling thread takes part in the work.
+	void ParallelFor(size_t count, size_t grain, const RangeFunction& func);
+};
\ No newline at end of file
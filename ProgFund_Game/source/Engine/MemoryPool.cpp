@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "MemoryPool.hpp"
+
+//*******************************************************************
+//FixedBlockPool
+//*******************************************************************
+FixedBlockPool::FixedBlockPool() {
+	sizeBlock_ = 0U;
+	countBlockPerChunk_ = 0U;
+	freeHead_ = nullptr;
+	countUsed_ = 0U;
+	countPeak_ = 0U;
+}
+FixedBlockPool::FixedBlockPool(size_t sizeBlock, size_t countBlockPerChunk) : FixedBlockPool() {
+	Initialize(sizeBlock, countBlockPerChunk);
+}
+FixedBlockPool::~FixedBlockPool() {
+	Release();
+}
+void FixedBlockPool::Initialize(size_t sizeBlock, size_t countBlockPerChunk) {
+	Release();
+
+	//Free blocks store the next pointer in place
+	sizeBlock_ = std::max(sizeBlock, sizeof(void*));
+	sizeBlock_ = (sizeBlock_ + alignof(std::max_align_t) - 1U) & ~(alignof(std::max_align_t) - 1U);
+	countBlockPerChunk_ = std::max(countBlockPerChunk, (size_t)1U);
+}
+void FixedBlockPool::Release() {
+	for (void* iChunk : listChunk_)
+		::operator delete(iChunk);
+	listChunk_.clear();
+	freeHead_ = nullptr;
+	countUsed_ = 0U;
+	countPeak_ = 0U;
+}
+
+void FixedBlockPool::_AddChunk() {
+	byte* chunk = (byte*)::operator new(sizeBlock_ * countBlockPerChunk_);
+	listChunk_.push_back(chunk);
+
+	//Link back to front so the first allocation hands out the start of the chunk
+	for (size_t i = countBlockPerChunk_; i > 0; --i) {
+		void* block = chunk + (i - 1U) * sizeBlock_;
+		*(void**)block = freeHead_;
+		freeHead_ = block;
+	}
+}
+void* FixedBlockPool::Allocate() {
+	std::lock_guard<std::mutex> lock(lock_);
+	if (freeHead_ == nullptr)
+		_AddChunk();
+	void* block = freeHead_;
+	freeHead_ = *(void**)block;
+	countPeak_ = std::max(countPeak_, ++countUsed_);
+	return block;
+}
+void FixedBlockPool::Deallocate(void* ptr) {
+	if (ptr == nullptr) return;
+	std::lock_guard<std::mutex> lock(lock_);
+	*(void**)ptr = freeHead_;
+	freeHead_ = ptr;
+	--countUsed_;
+}
+FixedBlockPool::Stats FixedBlockPool::GetStats() {
+	std::lock_guard<std::mutex> lock(lock_);
+	return Stats{ sizeBlock_, listChunk_.size(), listChunk_.size() * countBlockPerChunk_, countUsed_, countPeak_ };
+}
+
+//*******************************************************************
+//SizeClassPool
+//*******************************************************************
+SizeClassPool::SizeClassPool() {
+	countLarge_ = 0U;
+	for (size_t i = 0; i < CLASS_COUNT; ++i) {
+		size_t sizeBlock = MIN_CLASS_SIZE << i;
+		//Aim for 64KB chunks, but always fit at least 8 blocks
+		listPool_[i].Initialize(sizeBlock, std::max((size_t)0x10000 / sizeBlock, (size_t)8U));
+	}
+}
+SizeClassPool::~SizeClassPool() {
+}
+
+size_t SizeClassPool::GetClassIndex(size_t size) {
+	size_t index = 0U;
+	size_t sizeClass = MIN_CLASS_SIZE;
+	while (sizeClass < size) {
+		sizeClass <<= 1;
+		++index;
+	}
+	return index;
+}
+
+void* SizeClassPool::Allocate(size_t size) {
+	if (size > MAX_CLASS_SIZE) {
+		countLarge_.fetch_add(1U, std::memory_order_relaxed);
+		return ::operator new(size);
+	}
+	return listPool_[GetClassIndex(size)].Allocate();
+}
+void SizeClassPool::Deallocate(void* ptr, size_t size) {
+	if (ptr == nullptr) return;
+	if (size > MAX_CLASS_SIZE) {
+		countLarge_.fetch_sub(1U, std::memory_order_relaxed);
+		::operator delete(ptr);
+		return;
+	}
+	listPool_[GetClassIndex(size)].Deallocate(ptr);
+}
+
+void SizeClassPool::PrintStats(const char* name) {
+	printf("Pool %s:\n", name);
+	for (size_t i = 0; i < CLASS_COUNT; ++i) {
+		FixedBlockPool::Stats stats = listPool_[i].GetStats();
+		if (stats.countChunk == 0U) continue;
+		printf("  %5u bytes: %u/%u used (%.1f%%), peak %u, %u chunks\n",
+			(uint32_t)stats.sizeBlock, (uint32_t)stats.countUsed, (uint32_t)stats.countBlock,
+			stats.countUsed * 100.0 / stats.countBlock, (uint32_t)stats.countPeak, (uint32_t)stats.countChunk);
+	}
+	if (size_t countLarge = GetLargeCount())
+		printf("  Heap: %u live\n", (uint32_t)countLarge);
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+#include "../../pch.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+//*******************************************************************
+//FixedBlockPool
+//	Free list of equally sized blocks carved out of larger chunks.
+//	Chunks are only returned to the heap when the pool is destroyed.
+//*******************************************************************
+class FixedBlockPool {
+public:
+	struct Stats {
+		size_t sizeBlock;
+		size_t countChunk;
+		size_t countBlock;		//Capacity across all chunks
+		size_t countUsed;
+		size_t countPeak;
+	};
+private:
+	size_t sizeBlock_;
+	size_t countBlockPerChunk_;
+
+	std::vector<void*> listChunk_;
+	void* freeHead_;
+	size_t countUsed_;
+	size_t countPeak_;
+
+	std::mutex lock_;
+
+	void _AddChunk();
+public:
+	FixedBlockPool();
+	FixedBlockPool(size_t sizeBlock, size_t countBlockPerChunk);
+	~FixedBlockPool();
+
+	void Initialize(size_t sizeBlock, size_t countBlockPerChunk);
+	void Release();
+
+	void* Allocate();
+	void Deallocate(void* ptr);
+
+	size_t GetBlockSize() { return sizeBlock_; }
+	Stats GetStats();
+};
+
+//*******************************************************************
+//SizeClassPool
+//	Routes allocations to the smallest fitting FixedBlockPool.
+//	Sizes above the largest class go straight to the heap.
+//*******************************************************************
+class SizeClassPool {
+public:
+	static constexpr size_t MIN_CLASS_SIZE = 32U;
+	static constexpr size_t CLASS_COUNT = 8U;		//32 -> 4096 bytes
+	static constexpr size_t MAX_CLASS_SIZE = MIN_CLASS_SIZE << (CLASS_COUNT - 1U);
+private:
+	FixedBlockPool listPool_[CLASS_COUNT];
+	std::atomic<size_t> countLarge_;	//Live allocations that went to the heap
+public:
+	SizeClassPool();
+	~SizeClassPool();
+
+	static size_t GetClassIndex(size_t size);
+
+	void* Allocate(size_t size);
+	void Deallocate(void* ptr, size_t size);
+
+	FixedBlockPool::Stats GetClassStats(size_t iClass) { return listPool_[iClass].GetStats(); }
+	size_t GetLargeCount() { return countLarge_.load(std::memory_order_relaxed); }
+	//One line per class that was ever used
+	void PrintStats(const char* name);
+};
+
+//*******************************************************************
+//PoolAllocator
+//	Standard allocator over a SizeClassPool, mainly for std::allocate_shared
+//	so an object and its control block come from a single pool block.
+//*******************************************************************
+template<typename T>
+class PoolAllocator {
+	template<typename U> friend class PoolAllocator;
+private:
+	SizeClassPool* pool_;
+public:
+	typedef T value_type;
+
+	PoolAllocator(SizeClassPool* pool) noexcept : pool_(pool) {}
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U>& other) noexcept : pool_(other.pool_) {}
+
+	T* allocate(size_t count) {
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Pool blocks are only aligned to max_align_t.");
+		return (T*)pool_->Allocate(count * sizeof(T));
+	}
+	void deallocate(T* ptr, size_t count) noexcept {
+		pool_->Deallocate(ptr, count * sizeof(T));
+	}
+
+	template<typename U>
+	bool operator==(const PoolAllocator<U>& other) const noexcept { return pool_ == other.pool_; }
+	template<typename U>
+	bool operator!=(const PoolAllocator<U>& other) const noexcept { return pool_ != other.pool_; }
+};
+
+//*******************************************************************
+//AlignedArray
+//	Fixed-capacity buffer of plain data on an aligned boundary, for SIMD loads.
+//	The owner tracks how much of it is in use.
+//*******************************************************************
+template<typename T, size_t ALIGNMENT = 32U>
+class AlignedArray {
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+private:
+	T* data_;
+	size_t capacity_;
+
+	void _Free() {
+		if (data_)
+			::operator delete(data_, std::align_val_t(ALIGNMENT));
+		data_ = nullptr;
+		capacity_ = 0U;
+	}
+public:
+	AlignedArray() : data_(nullptr), capacity_(0U) {}
+	AlignedArray(const AlignedArray&) = delete;
+	AlignedArray& operator=(const AlignedArray&) = delete;
+	~AlignedArray() { _Free(); }
+
+	//Keeps the first countKeep elements; everything after them is zeroed
+	void Resize(size_t capacity, size_t countKeep) {
+		T* data = nullptr;
+		if (capacity > 0U) {
+			data = (T*)::operator new(capacity * sizeof(T), std::align_val_t(ALIGNMENT));
+			countKeep = std::min(countKeep, std::min(capacity, capacity_));
+			if (countKeep > 0U)
+				memcpy(data, data_, countKeep * sizeof(T));
+			memset(data + countKeep, 0, (capacity - countKeep) * sizeof(T));
+		}
+		_Free();
+		data_ = data;
+		capacity_ = capacity;
+	}
+
+	T* GetData() { return data_; }
+	const T* GetData() const { return data_; }
+	size_t GetCapacity() const { return capacity_; }
+
+	T& operator[](size_t index) { return data_[index]; }
+	const T& operator[](size_t index) const { return data_[index]; }
+};
\ No newline at end of file
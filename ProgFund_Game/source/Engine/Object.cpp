@@ -6,14 +6,39 @@
 //ObjectBase
 //*******************************************************************
 ObjectBase::ObjectBase() {
+	idObject_ = INVALID_OBJECT_ID;
 	type_ = TypeObject::Null;
 	renderPri_ = 40;
 	bVisible_ = true;
 	bDeleted_ = false;
+	bRemovePending_ = false;
 }
 ObjectBase::~ObjectBase() {
 }
 
+SizeClassPool* ObjectBase::GetPool() {
+	//Never destroyed, like the task pool
+	static SizeClassPool* pool = new SizeClassPool();
+	return pool;
+}
+
+void ObjectBase::Serialize(SnapshotWriter* writer) {
+	writer->Write(type_);
+	writer->Write(renderPri_);
+	writer->Write(bVisible_);
+	writer->Write(bDeleted_);
+
+	mapObjectValue_.Serialize(writer);
+}
+void ObjectBase::Restore(SnapshotReader* reader) {
+	reader->Read(type_);
+	reader->Read(renderPri_);
+	reader->Read(bVisible_);
+	reader->Read(bDeleted_);
+
+	mapObjectValue_.Restore(reader);
+}
+
 //*******************************************************************
 //RenderObject
 //*******************************************************************
@@ -37,6 +62,32 @@ RenderObject::RenderObject() {
 RenderObject::~RenderObject() {
 }
 
+//Resources and geometry are not part of the snapshot
+void RenderObject::Serialize(SnapshotWriter* writer) {
+	ObjectBase::Serialize(writer);
+	writer->Write(position_);
+	writer->Write(angle_);
+	writer->Write(angleX_);
+	writer->Write(angleY_);
+	writer->Write(angleZ_);
+	writer->Write(scale_);
+	writer->Write(color_);
+	writer->Write(primitiveType_);
+	writer->Write(blend_);
+}
+void RenderObject::Restore(SnapshotReader* reader) {
+	ObjectBase::Restore(reader);
+	reader->Read(position_);
+	reader->Read(angle_);
+	reader->Read(angleX_);
+	reader->Read(angleY_);
+	reader->Read(angleZ_);
+	reader->Read(scale_);
+	reader->Read(color_);
+	reader->Read(primitiveType_);
+	reader->Read(blend_);
+}
+
 D3DXMATRIX RenderObject::CreateWorldMatrix2D(D3DXVECTOR3* const position, D3DXVECTOR3* const angle,
 	D3DXVECTOR3* const scale, D3DXMATRIX* const camera)
 {
@@ -144,6 +195,21 @@ void RenderObject::SetAngleZ(float z) {
 	}
 }
 
+void RenderObject::GetRenderState(RenderState* state) {
+	state->position = position_;
+	state->angleX = angleX_;
+	state->angleY = angleY_;
+	state->angleZ = angleZ_;
+	state->scale = scale_;
+	state->color = color_;
+	state->scroll = D3DXVECTOR2(0, 0);
+
+	state->primitiveType = primitiveType_;
+	state->blend = blend_;
+	state->countVertex = vertex_.size();
+	state->countIndex = index_.size();
+}
+
 void RenderObject::SetVertex(size_t index, const VertexTLX& vertex) {
 	VertexTLX* dst = &vertex_[index];
 	memcpy(dst, &vertex, sizeof(VertexTLX));
@@ -172,6 +238,11 @@ void StaticRenderObject::Initialize() {
 void StaticRenderObject::Update() {
 }
 
+void StaticRenderObject::GetRenderState(RenderState* state) {
+	RenderObject::GetRenderState(state);
+	state->scroll = scroll_;
+}
+
 void StaticRenderObject::UpdateVertexBuffer() {
 	size_t sizeBuffer = bufferVertex_->GetSize();
 	if (vertex_.size() > sizeBuffer) {
@@ -227,16 +298,26 @@ StaticRenderObject2D::~StaticRenderObject2D() {
 }
 
 HRESULT StaticRenderObject2D::Render() {
+	RenderState state;
+	GetRenderState(&state);
+	return Render(state);
+}
+HRESULT StaticRenderObject2D::Render(const RenderState& state) {
 	if (shader_ == nullptr) return D3DERR_INVALIDCALL;
 
 	WindowMain* window = WindowMain::GetBase();
 	IDirect3DDevice9* device = WindowMain::GetBase()->GetDevice();
 
 	window->SetTextureFilter(D3DTEXF_LINEAR, D3DTEXF_LINEAR);
-	window->SetBlendMode(blend_);
+	window->SetBlendMode(state.blend);
 
-	D3DXMATRIX matWorld = RenderObject::CreateWorldMatrix2D(&position_, &angleX_, &angleY_,
-		&angleZ_, &scale_, nullptr);
+	D3DXVECTOR3 position = state.position;
+	D3DXVECTOR2 angleX = state.angleX;
+	D3DXVECTOR2 angleY = state.angleY;
+	D3DXVECTOR2 angleZ = state.angleZ;
+	D3DXVECTOR3 scale = state.scale;
+	D3DXMATRIX matWorld = RenderObject::CreateWorldMatrix2D(&position, &angleX, &angleY,
+		&angleZ, &scale, nullptr);
 
 	ID3DXEffect* effect = shader_->GetEffect();
 	{
@@ -246,9 +327,9 @@ HRESULT StaticRenderObject2D::Render() {
 		if (handle = effect->GetParameterBySemantic(nullptr, "VIEWPROJECTION"))
 			effect->SetMatrix(handle, window->GetViewportMatrix());
 		if (handle = effect->GetParameterBySemantic(nullptr, "OBJCOLOR"))
-			effect->SetVector(handle, &color_);
+			effect->SetVector(handle, &state.color);
 		if (handle = effect->GetParameterBySemantic(nullptr, "UVSCROLL"))
-			effect->SetFloatArray(handle, (float*)&scroll_, 2U);
+			effect->SetFloatArray(handle, (float*)&state.scroll, 2U);
 	}
 
 	shader_->SetTechnique("Render");
@@ -260,8 +341,9 @@ HRESULT StaticRenderObject2D::Render() {
 	device->SetStreamSource(0, bufferVertex_->GetBuffer(), 0, sizeof(VertexTLX));
 
 	{
-		size_t countPrim = GetPrimitiveCount();
-		bool bIndex = index_.size() > 0;
+		bool bIndex = state.countIndex > 0;
+		size_t countPrim = RenderObject::GetPrimitiveCount(state.primitiveType,
+			bIndex ? state.countIndex : state.countVertex);
 		if (bIndex) device->SetIndices(bufferIndex_->GetBuffer());
 
 		UINT countPass = 1;
@@ -271,9 +353,9 @@ HRESULT StaticRenderObject2D::Render() {
 			effect->BeginPass(iPass);
 
 			if (bIndex)
-				device->DrawIndexedPrimitive(primitiveType_, 0, 0, vertex_.size(), 0, countPrim);
+				device->DrawIndexedPrimitive(state.primitiveType, 0, 0, state.countVertex, 0, countPrim);
 			else
-				device->DrawPrimitive(primitiveType_, 0, countPrim);
+				device->DrawPrimitive(state.primitiveType, 0, countPrim);
 
 			effect->EndPass();
 		}
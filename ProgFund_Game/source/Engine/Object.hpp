@@ -3,35 +3,52 @@
 #include "../../pch.h"
 
 #include "Vertex.hpp"
+#include "Snapshot.hpp"
+#include "ObjectValue.hpp"
+#include "EntityStore.hpp"
+#include "MemoryPool.hpp"
+#include "SlotMap.hpp"
 #include "../Engine/ResourceManager.hpp"
 #include "../Engine/Window.hpp"
 
-enum class TypeObject : uint8_t {
-	Null,
-	Render,
-	Sound,
-	Player,
-	Enemy,
-	Shot,
-	Item,
-};
+class ObjectBase;
+class ObjectManager;
+
+typedef SlotMap<shared_ptr<ObjectBase>>::Handle ObjectID;
+constexpr ObjectID INVALID_OBJECT_ID = SlotMap<shared_ptr<ObjectBase>>::INVALID_HANDLE;
 
 class ObjectBase {
+	friend class ObjectManager;
 private:
+	ObjectID idObject_;
 	TypeObject type_;
 	size_t renderPri_;
 	bool bVisible_;
 	bool bDeleted_;
+	bool bRemovePending_;	//Deleted during an update, the manager still holds its slot
 
-	std::unordered_map<std::string, DWORD> mapObjectValue_;
+	ObjectValueMap mapObjectValue_;
 public:
 	ObjectBase();
 	virtual ~ObjectBase();
 
+	//Object and shared_ptr control block in one pool block instead of two heap allocations
+	template<class T, typename... Args>
+	static shared_ptr<T> Create(Args&&... args) {
+		static_assert(std::is_base_of<ObjectBase, T>::value, "T must derive from ObjectBase");
+		return std::allocate_shared<T>(PoolAllocator<T>(GetPool()), std::forward<Args>(args)...);
+	}
+	static SizeClassPool* GetPool();
+
 	virtual void Initialize() {}
 	virtual void Update() = 0;
 	virtual HRESULT Render() = 0;
 
+	virtual void Serialize(SnapshotWriter* writer);
+	virtual void Restore(SnapshotReader* reader);
+
+	//INVALID_OBJECT_ID unless the object is owned by an ObjectManager
+	ObjectID GetObjectID() { return idObject_; }
 	void SetType(TypeObject type) { type_ = type; }
 	TypeObject GetType() { return type_; }
 	void SetRenderPriority(size_t pri) { renderPri_ = pri; }
@@ -39,12 +56,27 @@ public:
 	bool IsVisible() { return bVisible_; }
 	bool IsDeleted() { return bDeleted_; }
 
-	bool IsObjectValueExists(const std::string& key) {
-		return mapObjectValue_.find(key) != mapObjectValue_.end();
-	}
-	DWORD GetObjectValue(const std::string& key) { return mapObjectValue_[key]; }
-	void SetObjectValue(const std::string& key, DWORD val) { mapObjectValue_[key] = val; }
-	void DeleteObjectValue(const std::string& key) { mapObjectValue_.erase(key); }
+	//Keys are "name"_key literals, or ValueKey::Intern for names built at runtime
+	bool IsObjectValueExists(ValueKey key) { return mapObjectValue_.IsExists(key); }
+	DWORD GetObjectValue(ValueKey key) { return mapObjectValue_[key]; }
+	void SetObjectValue(ValueKey key, DWORD val) { mapObjectValue_[key] = val; }
+	void DeleteObjectValue(ValueKey key) { mapObjectValue_.Erase(key); }
+};
+
+//Per-draw values of a RenderObject, so the draw can be issued later from another thread
+struct RenderState {
+	D3DXVECTOR3 position;
+	D3DXVECTOR2 angleX;
+	D3DXVECTOR2 angleY;
+	D3DXVECTOR2 angleZ;
+	D3DXVECTOR3 scale;
+	D3DXVECTOR4 color;
+	D3DXVECTOR2 scroll;
+
+	D3DPRIMITIVETYPE primitiveType;
+	BlendMode blend;
+	uint32_t countVertex;
+	uint32_t countIndex;
 };
 
 class RenderObject : public ObjectBase {
@@ -72,6 +104,13 @@ public:
 	virtual void Initialize() {}
 	virtual void Update() = 0;
 	virtual HRESULT Render() = 0;
+	//Draws with captured values instead of the current ones; resources and geometry are still the object's
+	virtual HRESULT Render(const RenderState& state) { return E_NOTIMPL; }
+
+	virtual void GetRenderState(RenderState* state);
+
+	virtual void Serialize(SnapshotWriter* writer);
+	virtual void Restore(SnapshotReader* reader);
 
 	static D3DXMATRIX CreateWorldMatrix2D(D3DXVECTOR3* const position, D3DXVECTOR3* const angle,
 		D3DXVECTOR3* const scale, D3DXMATRIX* const camera);
@@ -160,6 +199,8 @@ public:
 	virtual void Update();
 	virtual HRESULT Render() = 0;
 
+	virtual void GetRenderState(RenderState* state);
+
 	void UpdateVertexBuffer();
 	void UpdateIndexBuffer();
 	virtual void SetArrayVertex(const std::vector<VertexTLX>& vertices) {
@@ -205,6 +246,7 @@ public:
 	virtual ~StaticRenderObject2D();
 
 	virtual HRESULT Render();
+	virtual HRESULT Render(const RenderState& state);
 
 	bool IsPermitCamera() { return bPermitCamera_; }
 	void SetPermitCamera(bool bPermit) { bPermitCamera_ = bPermit; }
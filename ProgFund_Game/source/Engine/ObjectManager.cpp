@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "ObjectManager.hpp"
+#include "Profiler.hpp"
+
+//*******************************************************************
+//ObjectManager
+//*******************************************************************
+ObjectManager::ObjectManager() {
+	countDeleted_ = 0U;
+	bUpdating_ = false;
+}
+ObjectManager::~ObjectManager() {
+	Clear();
+}
+
+void ObjectManager::Reserve(size_t count) {
+	listObject_.Reserve(count);
+	listRender_.reserve(count);
+}
+void ObjectManager::Clear() {
+	if (bUpdating_) throw EngineError("ObjectManager: Objects can't be cleared during an update.");
+	for (shared_ptr<ObjectBase>& iObj : listObject_) {
+		iObj->bDeleted_ = true;
+		iObj->bRemovePending_ = false;
+		iObj->idObject_ = INVALID_OBJECT_ID;
+	}
+	//Slot generations are kept, IDs from before the clear stay stale
+	while (listObject_.GetSize() > 0U)
+		listObject_.EraseAt(listObject_.GetSize() - 1U);
+	countDeleted_ = 0U;
+}
+
+ObjectID ObjectManager::AddObject(shared_ptr<ObjectBase> obj) {
+	if (obj == nullptr) return INVALID_OBJECT_ID;
+	if (obj->idObject_ != INVALID_OBJECT_ID)
+		throw EngineError("ObjectManager: The object already has an ID.");
+	if (obj->bRemovePending_) {
+		//It would sit in two slots until the pass ends
+		if (bUpdating_)
+			throw EngineError("ObjectManager: The object can't be added again before its deletion completes.");
+		_RemoveDeleted();
+	}
+
+	ObjectID id = listObject_.Insert(obj);
+	obj->idObject_ = id;
+	obj->bDeleted_ = false;
+	return id;
+}
+void ObjectManager::DeleteObject(ObjectID id) {
+	ObjectBase* obj = GetObjectByID(id);
+	if (obj == nullptr) return;
+
+	//Removed in one compaction after the next pass, erasing right away would reorder the others
+	obj->bDeleted_ = true;
+	obj->bRemovePending_ = true;
+	obj->idObject_ = INVALID_OBJECT_ID;
+	++countDeleted_;
+}
+
+void ObjectManager::_RemoveDeleted() {
+	if (countDeleted_ == 0U) return;
+	//Stable, objects with equal render priority keep drawing in the same order
+	listObject_.EraseIf([](shared_ptr<ObjectBase>& obj) {
+		if (!obj->bRemovePending_) return false;
+		obj->bRemovePending_ = false;
+		return true;
+	});
+	countDeleted_ = 0U;
+}
+
+void ObjectManager::UpdateObjects() {
+	PROFILE_ZONE("ObjectManager::UpdateObjects");
+	bUpdating_ = true;
+	try {
+		for (size_t i = 0; i < listObject_.GetSize(); ++i) {
+			ObjectBase* obj = listObject_[i].get();
+			if (!obj->IsDeleted())
+				obj->Update();
+		}
+	}
+	catch (...) {
+		bUpdating_ = false;
+		_RemoveDeleted();
+		throw;
+	}
+	bUpdating_ = false;
+	_RemoveDeleted();
+}
+void ObjectManager::RenderObjects() {
+	PROFILE_ZONE("ObjectManager::RenderObjects");
+	listRender_.clear();
+	for (size_t i = 0; i < listObject_.GetSize(); ++i) {
+		ObjectBase* obj = listObject_[i].get();
+		if (obj->IsVisible() && !obj->IsDeleted())
+			listRender_.push_back(RenderEntry{ obj->GetRenderPriorityI(), i });
+	}
+	//std::sort with the index as tie-break; stable_sort would allocate every frame
+	std::sort(listRender_.begin(), listRender_.end(), [](const RenderEntry& a, const RenderEntry& b) {
+		return a.priority != b.priority ? a.priority < b.priority : a.index < b.index;
+	});
+	for (RenderEntry& iEntry : listRender_)
+		listObject_[iEntry.index]->Render();
+}
\ No newline at end of file
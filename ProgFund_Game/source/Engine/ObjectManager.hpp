@@ -0,0 +1,60 @@
+#pragma once
+#include "../../pch.h"
+
+#include "SlotMap.hpp"
+#include "Object.hpp"
+
+//*******************************************************************
+//ObjectManager
+//	Owns objects and refers to them by 32-bit ObjectIDs instead of shared_ptrs.
+//	An ID resolves with one slot read and a generation compare, so IDs of
+//	deleted objects fail instead of reaching whatever reused the slot.
+//	Slots and dense storage keep their capacity once grown; lookups never allocate.
+//*******************************************************************
+class ObjectManager {
+private:
+	struct RenderEntry {
+		size_t priority;
+		size_t index;
+	};
+
+	SlotMap<shared_ptr<ObjectBase>> listObject_;
+	std::vector<RenderEntry> listRender_;	//Sort scratch for RenderObjects
+
+	size_t countDeleted_;	//Deleted, still waiting to be removed
+	bool bUpdating_;
+
+	void _RemoveDeleted();
+public:
+	ObjectManager();
+	~ObjectManager();
+
+	void Reserve(size_t count);
+	void Clear();
+
+	ObjectID AddObject(shared_ptr<ObjectBase> obj);
+	template<class T, typename... Args>
+	ObjectID CreateObject(Args&&... args) {
+		return AddObject(ObjectBase::Create<T>(std::forward<Args>(args)...));
+	}
+	//The ID stops resolving right away; the object itself is kept until the end of the next UpdateObjects.
+	//	Adding it again during the pass throws
+	void DeleteObject(ObjectID id);
+
+	bool IsValid(ObjectID id) { return GetObjectByID(id) != nullptr; }
+	ObjectBase* GetObjectByID(ObjectID id) {
+		shared_ptr<ObjectBase>* obj = listObject_.Get(id);
+		return (obj && !(*obj)->IsDeleted()) ? obj->get() : nullptr;
+	}
+	template<class T>
+	T* GetObjectAs(ObjectID id) { return dynamic_cast<T*>(GetObjectByID(id)); }
+	shared_ptr<ObjectBase> GetSharedObject(ObjectID id) {
+		return GetObjectByID(id) ? *listObject_.Get(id) : nullptr;
+	}
+	size_t GetObjectCount() { return listObject_.GetSize() - countDeleted_; }
+
+	//Objects added during the pass are updated in the same pass
+	void UpdateObjects();
+	//Visible objects by render priority, ties in storage order
+	void RenderObjects();
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "pch.h"
+#include "ObjectValue.hpp"
+#include "Utility.hpp"
+
+#include <mutex>
+
+//*******************************************************************
+//ValueKey
+//*******************************************************************
+static std::mutex s_lockInterned;
+static std::unordered_map<uint64_t, std::string> s_mapInterned;
+
+ValueKey ValueKey::Intern(std::string_view str) {
+	ValueKey key(_Hash(str));
+
+	std::lock_guard<std::mutex> lock(s_lockInterned);
+	auto itrFind = s_mapInterned.find(key.hash_);
+	if (itrFind == s_mapInterned.end())
+		s_mapInterned.emplace(key.hash_, std::string(str));
+	else if (itrFind->second != str) {
+		throw EngineError(StringUtility::Format("ValueKey: \"%s\" and \"%s\" have the same hash.",
+			itrFind->second.c_str(), std::string(str).c_str()));
+	}
+	return key;
+}
+std::string ValueKey::GetName(ValueKey key) {
+	std::lock_guard<std::mutex> lock(s_lockInterned);
+	auto itrFind = s_mapInterned.find(key.hash_);
+	return itrFind != s_mapInterned.end() ? itrFind->second : std::string();
+}
+
+//*******************************************************************
+//ObjectValueMap
+//*******************************************************************
+bool ObjectValueMap::Erase(ValueKey key) {
+	uint64_t hash = key.GetHash();
+	size_t countInline = std::min<size_t>(count_, INLINE_CAPACITY);
+
+	//Move the last entry into the hole, pulling one back inline if any spilled
+	size_t index = SIZE_MAX;
+	for (size_t i = 0; i < countInline; ++i) {
+		if (listKey_[i] == hash) {
+			index = i;
+			break;
+		}
+	}
+	if (index != SIZE_MAX) {
+		if (listOverflow_.size() > 0) {
+			listKey_[index] = listOverflow_.back().key;
+			listValue_[index] = listOverflow_.back().value;
+			listOverflow_.pop_back();
+		}
+		else {
+			listKey_[index] = listKey_[countInline - 1U];
+			listValue_[index] = listValue_[countInline - 1U];
+		}
+		--count_;
+		return true;
+	}
+
+	for (size_t i = 0; i < listOverflow_.size(); ++i) {
+		if (listOverflow_[i].key == hash) {
+			listOverflow_[i] = listOverflow_.back();
+			listOverflow_.pop_back();
+			--count_;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ObjectValueMap::Serialize(SnapshotWriter* writer) {
+	writer->Write(count_);
+	size_t countInline = std::min<size_t>(count_, INLINE_CAPACITY);
+	writer->Write(listKey_, countInline * sizeof(uint64_t));
+	writer->Write(listValue_, countInline * sizeof(DWORD));
+	writer->WriteArray(listOverflow_);
+}
+void ObjectValueMap::Restore(SnapshotReader* reader) {
+	reader->Read(count_);
+	size_t countInline = std::min<size_t>(count_, INLINE_CAPACITY);
+	reader->Read(listKey_, countInline * sizeof(uint64_t));
+	reader->Read(listValue_, countInline * sizeof(DWORD));
+	reader->ReadArray(listOverflow_);
+	if (count_ != countInline + listOverflow_.size())
+		throw EngineError("ObjectValueMap: Snapshot entry count doesn't match.");
+}
\ No newline at end of file
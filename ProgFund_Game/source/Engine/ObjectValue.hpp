@@ -0,0 +1,127 @@
+#pragma once
+#include "../../pch.h"
+
+#include <string_view>
+
+#include "Snapshot.hpp"
+
+//*******************************************************************
+//ValueKey
+//	64-bit FNV-1a hash of a key name. Every key goes through one symbol
+//	table, which throws if two names hash the same and maps hashes back to
+//	names: names known at runtime through Intern, literals written as
+//	"name"_key through the same on their first use.
+//*******************************************************************
+class ValueKey {
+private:
+	uint64_t hash_;
+
+	static constexpr uint64_t _Hash(std::string_view str) {
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		for (char ch : str) {
+			hash ^= (uint8_t)ch;
+			hash *= 0x00000100000001b3ULL;
+		}
+		return hash;
+	}
+public:
+	constexpr ValueKey() : hash_(0U) {}
+	explicit constexpr ValueKey(uint64_t hash) : hash_(hash) {}
+
+	static ValueKey Intern(std::string_view str);
+	//Name an interned key was made from, empty if it never was
+	static std::string GetName(ValueKey key);
+
+	constexpr uint64_t GetHash() const { return hash_; }
+	constexpr bool operator==(const ValueKey& other) const { return hash_ == other.hash_; }
+	constexpr bool operator!=(const ValueKey& other) const { return hash_ != other.hash_; }
+};
+
+//String literal as a template argument, for "name"_key
+template<size_t N>
+struct ValueKeyLiteral {
+	char str[N];
+
+	consteval ValueKeyLiteral(const char(&src)[N]) {
+		for (size_t i = 0; i < N; ++i)
+			str[i] = src[i];
+	}
+	constexpr std::string_view GetName() const { return std::string_view(str, N - 1U); }
+};
+//Each distinct literal is interned once, the first time any of its uses runs
+template<ValueKeyLiteral S>
+ValueKey operator""_key() {
+	static const ValueKey key = ValueKey::Intern(S.GetName());
+	return key;
+}
+
+//*******************************************************************
+//ObjectValueMap
+//	Key -> value storage for the handful of values an object usually has.
+//	The first INLINE_CAPACITY live inside the object and are found with a
+//	linear scan over their hashes; more spill into a heap array.
+//*******************************************************************
+class ObjectValueMap {
+public:
+	static constexpr size_t INLINE_CAPACITY = 8U;
+
+	//No padding bytes, snapshots get hashed byte for byte
+	struct Entry {
+		uint64_t key;
+		DWORD value;
+		DWORD reserved;
+	};
+private:
+	uint32_t count_;
+	uint64_t listKey_[INLINE_CAPACITY];
+	DWORD listValue_[INLINE_CAPACITY];
+	std::vector<Entry> listOverflow_;
+
+	DWORD* _Find(uint64_t key) {
+		size_t countInline = std::min<size_t>(count_, INLINE_CAPACITY);
+		for (size_t i = 0; i < countInline; ++i) {
+			if (listKey_[i] == key) return &listValue_[i];
+		}
+		for (Entry& iEntry : listOverflow_) {
+			if (iEntry.key == key) return &iEntry.value;
+		}
+		return nullptr;
+	}
+public:
+	ObjectValueMap() : count_(0U) {}
+
+	bool IsExists(ValueKey key) { return _Find(key.GetHash()) != nullptr; }
+	DWORD* Find(ValueKey key) { return _Find(key.GetHash()); }
+
+	//Inserts 0 for missing keys, like std::unordered_map's operator[]
+	DWORD& operator[](ValueKey key) {
+		uint64_t hash = key.GetHash();
+		if (DWORD* value = _Find(hash))
+			return *value;
+
+		if (count_ < INLINE_CAPACITY) {
+			listKey_[count_] = hash;
+			listValue_[count_] = 0U;
+			return listValue_[count_++];
+		}
+		++count_;
+		listOverflow_.push_back(Entry{ hash, 0U, 0U });
+		return listOverflow_.back().value;
+	}
+	void Set(ValueKey key, DWORD value) { (*this)[key] = value; }
+	bool Erase(ValueKey key);
+	void Clear() {
+		count_ = 0U;
+		listOverflow_.clear();
+	}
+
+	size_t GetSize() { return count_; }
+	Entry GetEntry(size_t index) {
+		if (index < INLINE_CAPACITY)
+			return Entry{ listKey_[index], listValue_[index], 0U };
+		return listOverflow_[index - INLINE_CAPACITY];
+	}
+
+	void Serialize(SnapshotWriter* writer);
+	void Restore(SnapshotReader* reader);
+};
\ No newline at end of file
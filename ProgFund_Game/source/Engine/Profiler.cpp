@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "Profiler.hpp"
+#include "Utility.hpp"
+
+//*******************************************************************
+//ProfileRing
+//*******************************************************************
+ProfileRing::ProfileRing(uint32_t idThread) {
+	idThread_ = idThread;
+	head_ = 0U;
+	listEvent_.reset(new Event[CAPACITY]);
+}
+
+void ProfileRing::CopyEvents(std::vector<Event>* dst) {
+	uint64_t head = head_.load(std::memory_order_acquire);
+	uint64_t count = std::min<uint64_t>(head, CAPACITY);
+	for (uint64_t i = head - count; i < head; ++i)
+		dst->push_back(listEvent_[i & (CAPACITY - 1U)]);
+}
+
+//*******************************************************************
+//Profiler
+//*******************************************************************
+std::mutex Profiler::lockRing_;
+std::vector<std::unique_ptr<ProfileRing>> Profiler::listRing_;
+const stdch::steady_clock::time_point Profiler::timeStart_ = stdch::steady_clock::now();
+
+ProfileRing* Profiler::GetThreadRing() {
+	//Rings outlive their threads so events from finished workers can still be exported
+	static thread_local ProfileRing* ring = nullptr;
+	if (ring == nullptr) {
+		std::lock_guard<std::mutex> lock(lockRing_);
+		listRing_.push_back(std::make_unique<ProfileRing>((uint32_t)listRing_.size()));
+		ring = listRing_.back().get();
+	}
+	return ring;
+}
+
+void Profiler::Clear() {
+	std::lock_guard<std::mutex> lock(lockRing_);
+	for (auto& iRing : listRing_)
+		iRing->Clear();
+}
+
+static void _WriteJsonString(std::ofstream& stream, const char* str) {
+	stream << '"';
+	for (; *str; ++str) {
+		char ch = *str;
+		if (ch == '"' || ch == '\\') stream << '\\' << ch;
+		else if ((unsigned char)ch < 0x20) stream << ' ';
+		else stream << ch;
+	}
+	stream << '"';
+}
+void Profiler::ExportChromeTrace(const std::string& path) {
+	std::ofstream stream(path, std::ios::out | std::ios::trunc);
+	if (!stream.is_open())
+		throw EngineError(StringUtility::Format("Profiler: Failed to open %s for writing.", path.c_str()));
+
+	std::vector<ProfileRing::Event> listEvent;
+	listEvent.reserve(ProfileRing::CAPACITY);
+
+	//Complete ("X") events, nesting is inferred from the time ranges
+	stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool bFirst = true;
+	char buf[128];
+	{
+		std::lock_guard<std::mutex> lock(lockRing_);
+		for (auto& iRing : listRing_) {
+			listEvent.clear();
+			iRing->CopyEvents(&listEvent);
+
+			for (ProfileRing::Event& iEvent : listEvent) {
+				if (!bFirst) stream << ',';
+				bFirst = false;
+
+				stream << "\n{\"name\":";
+				_WriteJsonString(stream, iEvent.name);
+				snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					iRing->GetThreadID(), iEvent.begin / 1000.0, (iEvent.end - iEvent.begin) / 1000.0);
+				stream << buf;
+			}
+		}
+	}
+	stream << "\n]}\n";
+}
\ No newline at end of file
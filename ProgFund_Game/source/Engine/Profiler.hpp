@@ -0,0 +1,81 @@
+#pragma once
+#include "../../pch.h"
+
+#include <mutex>
+#include <atomic>
+
+//*******************************************************************
+//ProfileRing
+//	Per-thread event ring. Only the owning thread writes; readers copy out
+//	whatever was published before the last head store.
+//*******************************************************************
+class ProfileRing {
+public:
+	static constexpr size_t CAPACITY = 1U << 16;	//Must be a power of 2
+
+	struct Event {
+		const char* name;	//Must outlive the profiler, string literals or type names
+		uint64_t begin;
+		uint64_t end;
+	};
+private:
+	uint32_t idThread_;
+	std::atomic<uint64_t> head_;
+	std::unique_ptr<Event[]> listEvent_;
+public:
+	ProfileRing(uint32_t idThread);
+
+	void Push(const char* name, uint64_t begin, uint64_t end) {
+		uint64_t head = head_.load(std::memory_order_relaxed);
+		listEvent_[head & (CAPACITY - 1U)] = Event{ name, begin, end };
+		head_.store(head + 1U, std::memory_order_release);
+	}
+	//Copies the newest events, up to CAPACITY
+	void CopyEvents(std::vector<Event>* dst);
+	void Clear() { head_.store(0U, std::memory_order_release); }
+
+	uint32_t GetThreadID() { return idThread_; }
+};
+
+//*******************************************************************
+//Profiler
+//*******************************************************************
+class Profiler {
+	static std::mutex lockRing_;
+	static std::vector<std::unique_ptr<ProfileRing>> listRing_;
+	static const stdch::steady_clock::time_point timeStart_;
+public:
+	//Nanoseconds since startup
+	static inline uint64_t GetTime() {
+		return (uint64_t)stdch::duration_cast<stdch::nanoseconds>(
+			stdch::steady_clock::now() - timeStart_).count();
+	}
+	//Registers the ring on a thread's first zone, lock-free afterwards
+	static ProfileRing* GetThreadRing();
+
+	//Both should only be called while no zones are open on other threads
+	static void Clear();
+	static void ExportChromeTrace(const std::string& path);
+};
+
+//*******************************************************************
+//ProfileZone
+//*******************************************************************
+class ProfileZone {
+	const char* name_;
+	uint64_t timeBegin_;
+public:
+	ProfileZone(const char* name) : name_(name), timeBegin_(Profiler::GetTime()) {}
+	~ProfileZone() {
+		Profiler::GetThreadRing()->Push(name_, timeBegin_, Profiler::GetTime());
+	}
+};
+
+#define __L_PROFILE_CONCAT_(a, b) a##b
+#define __L_PROFILE_CONCAT(a, b) __L_PROFILE_CONCAT_(a, b)
+
+#ifdef __L_PROFILE
+#define PROFILE_ZONE(name) ProfileZone __L_PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
\ No newline at end of file
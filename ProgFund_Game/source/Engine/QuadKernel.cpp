@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "QuadKernel.hpp"
+
+//A quad is 12 pairs of floats: (x, y), (z, color), (u, v) for each corner. The kernels build
+//	registers of such pairs per corner, xy, zc and uv, with lanes 0, 1 in the lo registers and
+//	2, 3 in the hi ones, then each 16 bytes of output takes one shuffle of two pairs.
+static inline __m128 _PairLane(__m128 a, __m128 b, bool bOdd) {
+	return bOdd ? _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 3, 2)) : _mm_movelh_ps(a, b);
+}
+static inline void _StoreQuad(float* dst, const __m128 xy[4], __m128 zc, const __m128 uv[4], bool bOdd) {
+	_mm_storeu_ps(dst + 0, _PairLane(xy[0], zc, bOdd));
+	_mm_storeu_ps(dst + 4, _PairLane(uv[0], xy[1], bOdd));
+	_mm_storeu_ps(dst + 8, _PairLane(zc, uv[1], bOdd));
+	_mm_storeu_ps(dst + 12, _PairLane(xy[2], zc, bOdd));
+	_mm_storeu_ps(dst + 16, _PairLane(uv[2], xy[3], bOdd));
+	_mm_storeu_ps(dst + 20, _PairLane(zc, uv[3], bOdd));
+}
+
+//The same on 256 bits, where the pairs of lane n and n + 4 share a register: their
+//	16-byte halves are regrouped into 32-byte stores, 3 per quad.
+SIMD_TARGET_AVX static inline __m256 _PairLane(__m256 a, __m256 b, bool bOdd) {
+	return bOdd ? _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 3, 2)) : _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 1, 0));
+}
+SIMD_TARGET_AVX static inline void _StoreQuadPair(float* dst, float* dstUpper,
+	const __m256 xy[4], __m256 zc, const __m256 uv[4], bool bOdd)
+{
+	__m256 pair0 = _PairLane(xy[0], zc, bOdd);
+	__m256 pair1 = _PairLane(uv[0], xy[1], bOdd);
+	__m256 pair2 = _PairLane(zc, uv[1], bOdd);
+	__m256 pair3 = _PairLane(xy[2], zc, bOdd);
+	__m256 pair4 = _PairLane(uv[2], xy[3], bOdd);
+	__m256 pair5 = _PairLane(zc, uv[3], bOdd);
+	_mm256_storeu_ps(dst + 0, _mm256_permute2f128_ps(pair0, pair1, 0x20));
+	_mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(pair2, pair3, 0x20));
+	_mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(pair4, pair5, 0x20));
+	_mm256_storeu_ps(dstUpper + 0, _mm256_permute2f128_ps(pair0, pair1, 0x31));
+	_mm256_storeu_ps(dstUpper + 8, _mm256_permute2f128_ps(pair2, pair3, 0x31));
+	_mm256_storeu_ps(dstUpper + 16, _mm256_permute2f128_ps(pair4, pair5, 0x31));
+}
+
+//*******************************************************************
+//QuadKernel
+//*******************************************************************
+void QuadKernel::Build(const QuadSource& src, size_t count, QuadVertex* dst, SimdLevel level) {
+	switch (CpuFeature::Resolve(level)) {
+	case SimdLevel::AVX2:
+	case SimdLevel::AVX:
+		_BuildAVX(src, 0U, count, dst);
+		break;
+	case SimdLevel::SSE2:
+		_BuildSSE2(src, 0U, count, dst);
+		break;
+	default:
+		_BuildScalar(src, 0U, count, dst);
+		break;
+	}
+}
+
+//Per quad, in this exact order in every kernel:
+//	wc = hw * cos, ws = hw * sin, hc = hh * cos, hs = hh * sin
+//	TL = (x - wc + hs, y - ws - hc)		TR = (x + wc + hs, y + ws - hc)
+//	BL = (x - wc - hs, y - ws + hc)		BR = (x + wc - hs, y + ws + hc)
+void QuadKernel::_BuildScalar(const QuadSource& src, size_t begin, size_t end, QuadVertex* dst) {
+	for (size_t i = begin; i < end; ++i) {
+		float hw = src.halfWidth[i];
+		float hh = src.halfHeight[i];
+		float wc = hw * src.cos[i], ws = hw * src.sin[i];
+		float hc = hh * src.cos[i], hs = hh * src.sin[i];
+		float left = src.x[i] - wc, right = src.x[i] + wc;
+		float top = src.y[i] - ws, bottom = src.y[i] + ws;
+
+		uint32_t color = src.color[i];
+		QuadVertex* vertex = &dst[i * 4U];
+		vertex[0] = QuadVertex{ left + hs, top - hc, 1.0f, color, src.u0[i], src.v0[i] };
+		vertex[1] = QuadVertex{ right + hs, bottom - hc, 1.0f, color, src.u1[i], src.v0[i] };
+		vertex[2] = QuadVertex{ left - hs, top + hc, 1.0f, color, src.u0[i], src.v1[i] };
+		vertex[3] = QuadVertex{ right - hs, bottom + hc, 1.0f, color, src.u1[i], src.v1[i] };
+	}
+}
+
+void QuadKernel::_BuildSSE2(const QuadSource& src, size_t begin, size_t end, QuadVertex* dst) {
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	size_t i = begin;
+	for (; i + 4U <= end; i += 4U) {
+		__m128 hw = _mm_loadu_ps(src.halfWidth + i);
+		__m128 hh = _mm_loadu_ps(src.halfHeight + i);
+		__m128 c = _mm_loadu_ps(src.cos + i);
+		__m128 s = _mm_loadu_ps(src.sin + i);
+		__m128 wc = _mm_mul_ps(hw, c), ws = _mm_mul_ps(hw, s);
+		__m128 hc = _mm_mul_ps(hh, c), hs = _mm_mul_ps(hh, s);
+		__m128 x = _mm_loadu_ps(src.x + i);
+		__m128 y = _mm_loadu_ps(src.y + i);
+		__m128 left = _mm_sub_ps(x, wc), right = _mm_add_ps(x, wc);
+		__m128 top = _mm_sub_ps(y, ws), bottom = _mm_add_ps(y, ws);
+
+		__m128 color = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(src.color + i)));
+		__m128 u0 = _mm_loadu_ps(src.u0 + i), u1 = _mm_loadu_ps(src.u1 + i);
+		__m128 v0 = _mm_loadu_ps(src.v0 + i), v1 = _mm_loadu_ps(src.v1 + i);
+
+		__m128 listX[4] = {
+			_mm_add_ps(left, hs), _mm_add_ps(right, hs),
+			_mm_sub_ps(left, hs), _mm_sub_ps(right, hs),
+		};
+		__m128 listY[4] = {
+			_mm_sub_ps(top, hc), _mm_sub_ps(bottom, hc),
+			_mm_add_ps(top, hc), _mm_add_ps(bottom, hc),
+		};
+		__m128 listU[4] = { u0, u1, u0, u1 };
+		__m128 listV[4] = { v0, v0, v1, v1 };
+
+		float* quad = &dst[i * 4U].x;
+		{
+			__m128 xy[4], uv[4];
+			for (size_t iCorner = 0; iCorner < 4U; ++iCorner) {
+				xy[iCorner] = _mm_unpacklo_ps(listX[iCorner], listY[iCorner]);
+				uv[iCorner] = _mm_unpacklo_ps(listU[iCorner], listV[iCorner]);
+			}
+			__m128 zc = _mm_unpacklo_ps(one, color);
+			_StoreQuad(quad, xy, zc, uv, false);
+			_StoreQuad(quad + 24, xy, zc, uv, true);
+		}
+		{
+			__m128 xy[4], uv[4];
+			for (size_t iCorner = 0; iCorner < 4U; ++iCorner) {
+				xy[iCorner] = _mm_unpackhi_ps(listX[iCorner], listY[iCorner]);
+				uv[iCorner] = _mm_unpackhi_ps(listU[iCorner], listV[iCorner]);
+			}
+			__m128 zc = _mm_unpackhi_ps(one, color);
+			_StoreQuad(quad + 48, xy, zc, uv, false);
+			_StoreQuad(quad + 72, xy, zc, uv, true);
+		}
+	}
+	_BuildScalar(src, i, end, dst);
+}
+
+SIMD_TARGET_AVX void QuadKernel::_BuildAVX(const QuadSource& src, size_t begin, size_t end, QuadVertex* dst) {
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	size_t i = begin;
+	for (; i + 8U <= end; i += 8U) {
+		__m256 hw = _mm256_loadu_ps(src.halfWidth + i);
+		__m256 hh = _mm256_loadu_ps(src.halfHeight + i);
+		__m256 c = _mm256_loadu_ps(src.cos + i);
+		__m256 s = _mm256_loadu_ps(src.sin + i);
+		__m256 wc = _mm256_mul_ps(hw, c), ws = _mm256_mul_ps(hw, s);
+		__m256 hc = _mm256_mul_ps(hh, c), hs = _mm256_mul_ps(hh, s);
+		__m256 x = _mm256_loadu_ps(src.x + i);
+		__m256 y = _mm256_loadu_ps(src.y + i);
+		__m256 left = _mm256_sub_ps(x, wc), right = _mm256_add_ps(x, wc);
+		__m256 top = _mm256_sub_ps(y, ws), bottom = _mm256_add_ps(y, ws);
+
+		__m256 color = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(src.color + i)));
+		__m256 u0 = _mm256_loadu_ps(src.u0 + i), u1 = _mm256_loadu_ps(src.u1 + i);
+		__m256 v0 = _mm256_loadu_ps(src.v0 + i), v1 = _mm256_loadu_ps(src.v1 + i);
+
+		__m256 listX[4] = {
+			_mm256_add_ps(left, hs), _mm256_add_ps(right, hs),
+			_mm256_sub_ps(left, hs), _mm256_sub_ps(right, hs),
+		};
+		__m256 listY[4] = {
+			_mm256_sub_ps(top, hc), _mm256_sub_ps(bottom, hc),
+			_mm256_add_ps(top, hc), _mm256_add_ps(bottom, hc),
+		};
+		__m256 listU[4] = { u0, u1, u0, u1 };
+		__m256 listV[4] = { v0, v0, v1, v1 };
+
+		//Quads 0, 1 and 4, 5 from the lo registers, 2, 3 and 6, 7 from the hi ones
+		float* quad = &dst[i * 4U].x;
+		{
+			__m256 xy[4], uv[4];
+			for (size_t iCorner = 0; iCorner < 4U; ++iCorner) {
+				xy[iCorner] = _mm256_unpacklo_ps(listX[iCorner], listY[iCorner]);
+				uv[iCorner] = _mm256_unpacklo_ps(listU[iCorner], listV[iCorner]);
+			}
+			__m256 zc = _mm256_unpacklo_ps(one, color);
+			_StoreQuadPair(quad, quad + 96, xy, zc, uv, false);
+			_StoreQuadPair(quad + 24, quad + 120, xy, zc, uv, true);
+		}
+		{
+			__m256 xy[4], uv[4];
+			for (size_t iCorner = 0; iCorner < 4U; ++iCorner) {
+				xy[iCorner] = _mm256_unpackhi_ps(listX[iCorner], listY[iCorner]);
+				uv[iCorner] = _mm256_unpackhi_ps(listU[iCorner], listV[iCorner]);
+			}
+			__m256 zc = _mm256_unpackhi_ps(one, color);
+			_StoreQuadPair(quad + 48, quad + 144, xy, zc, uv, false);
+			_StoreQuadPair(quad + 72, quad + 168, xy, zc, uv, true);
+		}
+	}
+	//The tail is SSE code, and the compiler doesn't clear the upper halves before a tail call
+	_mm256_zeroupper();
+	_BuildScalar(src, i, end, dst);
+}
\ No newline at end of file
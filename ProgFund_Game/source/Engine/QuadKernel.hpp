@@ -0,0 +1,47 @@
+#pragma once
+#include "../../pch.h"
+
+#include "Simd.hpp"
+
+//Same layout as VertexTLX, which can't be used without DirectX
+struct QuadVertex {
+	float x, y, z;
+	uint32_t color;
+	float u, v;
+};
+
+//Structure-of-arrays input of QuadKernel, every array holds count elements
+struct QuadSource {
+	const float* x;
+	const float* y;
+	const float* cos;
+	const float* sin;
+	const float* halfWidth;		//Scale already applied
+	const float* halfHeight;
+	const float* u0;
+	const float* v0;
+	const float* u1;
+	const float* v1;
+	const uint32_t* color;
+};
+
+//*******************************************************************
+//QuadKernel
+//	Expands rotated rects into packed quads, 4 vertices each ordered TL, TR,
+//	BL, BR for VertexBufferManager's quad index buffer. The SIMD kernels
+//	regroup lanes into vertices in registers and write whole quads with full
+//	16 or 32-byte stores. Every kernel does the same float operations, so
+//	they agree bit for bit.
+//*******************************************************************
+class QuadKernel {
+private:
+	static void _BuildScalar(const QuadSource& src, size_t begin, size_t end, QuadVertex* dst);
+	static void _BuildSSE2(const QuadSource& src, size_t begin, size_t end, QuadVertex* dst);
+	SIMD_TARGET_AVX static void _BuildAVX(const QuadSource& src, size_t begin, size_t end, QuadVertex* dst);
+public:
+	//dst receives count * 4 vertices, z is 1 as in Sprite2D. The level is clamped to what the CPU supports.
+	static void Build(const QuadSource& src, size_t count, QuadVertex* dst, SimdLevel level);
+	static void Build(const QuadSource& src, size_t count, QuadVertex* dst) {
+		Build(src, count, dst, CpuFeature::GetSimdLevel());
+	}
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include "../../pch.h"
+
+//*******************************************************************
+//RandomGenerator
+//	xoshiro256** seeded through splitmix64. Same seed, same sequence on
+//	every platform; the state is plain data so it can be snapshotted.
+//*******************************************************************
+class RandomGenerator {
+private:
+	uint64_t seed_;
+	uint64_t state_[4];
+
+	static inline uint64_t _Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+public:
+	RandomGenerator(uint64_t seed = 0U) { SetSeed(seed); }
+
+	void SetSeed(uint64_t seed) {
+		seed_ = seed;
+		for (size_t i = 0; i < 4; ++i) {
+			seed += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			state_[i] = z ^ (z >> 31);
+		}
+	}
+	uint64_t GetSeed() const { return seed_; }
+
+	uint64_t Next() {
+		uint64_t res = _Rotl(state_[1] * 5U, 7) * 9U;
+		uint64_t t = state_[1] << 17;
+		state_[2] ^= state_[0];
+		state_[3] ^= state_[1];
+		state_[1] ^= state_[2];
+		state_[0] ^= state_[3];
+		state_[2] ^= t;
+		state_[3] = _Rotl(state_[3], 45);
+		return res;
+	}
+
+	//[0, 1), exact: built from the top 53 bits without any libm call
+	double GetReal() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+	double GetReal(double min, double max) { return min + (max - min) * GetReal(); }
+	//[min, max]
+	int64_t GetInt(int64_t min, int64_t max) {
+		if (max <= min) return min;
+		uint64_t range = (uint64_t)(max - min) + 1U;
+		return range == 0U ? (int64_t)Next() : min + (int64_t)(Next() % range);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "RenderPipeline.hpp"
+#include "Profiler.hpp"
+
+//*******************************************************************
+//RenderFrame
+//*******************************************************************
+RenderFrame::RenderFrame() {
+	frame_ = 0U;
+	interpolation_ = 0.0f;
+}
+
+void RenderFrame::Clear() {
+	listTask_.clear();
+	listItem_.clear();
+}
+
+void RenderFrame::AddObject(RenderObject* object) {
+	Item item;
+	item.object = object;
+	object->GetRenderState(&item.state);
+	listItem_.push_back(item);
+}
+void RenderFrame::AddObject(RenderObject* object, const RenderState& state) {
+	listItem_.push_back(Item{ object, state });
+}
+
+void RenderFrame::Render() {
+	PROFILE_ZONE("RenderFrame::Render");
+	for (Item& iItem : listItem_)
+		iItem.object->Render(iItem.state);
+}
+
+//*******************************************************************
+//RenderPipeline
+//*******************************************************************
+RenderPipeline::RenderPipeline() {
+	scene_ = nullptr;
+	bRequest_ = false;
+	bBusy_ = false;
+	bStop_ = false;
+	countUpdate_ = 0U;
+	interpolation_ = 0.0f;
+	input_ = InputState{ 0U };
+	timeSimulation_ = 0U;
+	timeRender_ = 0U;
+	indexRender_ = 0U;
+}
+RenderPipeline::~RenderPipeline() {
+	Release();
+}
+
+void RenderPipeline::Initialize(Scene* scene) {
+	if (threadSim_.joinable())
+		throw EngineError("RenderPipeline already initialized.");
+	scene_ = scene;
+	bStop_ = false;
+	threadSim_ = std::thread(&RenderPipeline::_SimulationProc, this);
+}
+void RenderPipeline::Release() {
+	if (!threadSim_.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(lock_);
+		bStop_ = true;
+	}
+	cvSim_.notify_one();
+	threadSim_.join();
+
+	for (RenderFrame& iFrame : listFrame_)
+		iFrame.Clear();
+	scene_ = nullptr;
+}
+
+void RenderPipeline::_WaitSimulation(std::unique_lock<std::mutex>& lock) {
+	cvDone_.wait(lock, [&]() { return !bRequest_ && !bBusy_; });
+	if (pError_) {
+		std::exception_ptr pError = pError_;
+		pError_ = nullptr;
+		std::rethrow_exception(pError);
+	}
+}
+void RenderPipeline::Kick(size_t countUpdate, float interpolation, const InputState& input) {
+	std::unique_lock<std::mutex> lock(lock_);
+	_WaitSimulation(lock);
+
+	//The simulation thread is idle here, so the buffers can be swapped freely
+	indexRender_ ^= 1U;
+	timeRender_ = timeSimulation_;
+	countUpdate_ = countUpdate;
+	interpolation_ = interpolation;
+	input_ = input;
+	bRequest_ = true;
+
+	lock.unlock();
+	cvSim_.notify_one();
+}
+void RenderPipeline::Flush() {
+	std::unique_lock<std::mutex> lock(lock_);
+	_WaitSimulation(lock);
+}
+
+void RenderPipeline::_SimulationProc() {
+	while (true) {
+		size_t countUpdate;
+		float interpolation;
+		InputState input;
+		RenderFrame* frame;
+		{
+			std::unique_lock<std::mutex> lock(lock_);
+			cvSim_.wait(lock, [&]() { return bRequest_ || bStop_; });
+			if (bStop_) break;
+			bRequest_ = false;
+			bBusy_ = true;
+
+			countUpdate = countUpdate_;
+			interpolation = interpolation_;
+			input = input_;
+			frame = &listFrame_[indexRender_ ^ 1U];
+		}
+
+		std::exception_ptr pError = nullptr;
+		auto timeStart = stdch::steady_clock::now();
+		try {
+			PROFILE_ZONE("RenderPipeline::Simulate");
+			for (size_t i = 0; i < countUpdate; ++i) {
+				scene_->SetInput(input);
+				scene_->Update();
+			}
+			scene_->SetInterpolation(interpolation);
+
+			frame->Clear();
+			frame->frame_ = scene_->GetFrame();
+			frame->interpolation_ = interpolation;
+			scene_->GetRenderTasks(&frame->listTask_);
+			for (shared_ptr<TaskBase>& iTask : frame->listTask_)
+				iTask->Extract(frame);
+		}
+		catch (...) {
+			pError = std::current_exception();
+		}
+		auto timeEnd = stdch::steady_clock::now();
+
+		{
+			std::lock_guard<std::mutex> lock(lock_);
+			bBusy_ = false;
+			timeSimulation_ = (uint64_t)stdch::duration_cast<stdch::nanoseconds>(timeEnd - timeStart).count();
+			if (pError && !pError_)
+				pError_ = std::move(pError);
+		}
+		cvDone_.notify_all();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+#include "../../pch.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Scene.hpp"
+#include "Object.hpp"
+
+//*******************************************************************
+//RenderFrame
+//	Everything the render thread needs to draw one simulated frame. Only
+//	the simulation thread writes to it, and only while the render thread
+//	isn't reading it.
+//*******************************************************************
+class RenderFrame {
+	friend class RenderPipeline;
+public:
+	struct Item {
+		RenderObject* object;
+		RenderState state;
+	};
+private:
+	size_t frame_;
+	float interpolation_;
+
+	std::vector<shared_ptr<TaskBase>> listTask_;	//Keeps the objects alive until drawn
+	std::vector<Item> listItem_;
+public:
+	RenderFrame();
+
+	void Clear();
+
+	//The object must belong to a task of the frame, and its geometry must not change while pipelined
+	void AddObject(RenderObject* object);
+	void AddObject(RenderObject* object, const RenderState& state);
+
+	void Render();
+
+	size_t GetFrame() { return frame_; }
+	float GetInterpolation() { return interpolation_; }
+	size_t GetItemCount() { return listItem_.size(); }
+};
+
+//*******************************************************************
+//RenderPipeline
+//	Updates a Scene on its own thread while the previous frame is drawn.
+//	Frames are double-buffered: the render thread draws frame N while N+1
+//	is simulated, so output lags the simulation by exactly one frame.
+//*******************************************************************
+class RenderPipeline {
+private:
+	Scene* scene_;
+	std::thread threadSim_;
+
+	std::mutex lock_;
+	std::condition_variable cvSim_;
+	std::condition_variable cvDone_;
+	bool bRequest_;
+	bool bBusy_;
+	bool bStop_;
+	std::exception_ptr pError_;
+
+	size_t countUpdate_;
+	float interpolation_;
+	InputState input_;
+	uint64_t timeSimulation_;
+	uint64_t timeRender_;		//timeSimulation_ of the render frame
+
+	RenderFrame listFrame_[2];
+	size_t indexRender_;
+
+	void _SimulationProc();
+	void _WaitSimulation(std::unique_lock<std::mutex>& lock);
+public:
+	RenderPipeline();
+	~RenderPipeline();
+
+	void Initialize(Scene* scene);
+	void Release();
+
+	//Render thread only. Waits for the frame in flight, makes it the render
+	//	frame, then starts simulating the next one in the other buffer.
+	//	The input is applied to each of the updates.
+	void Kick(size_t countUpdate, float interpolation, const InputState& input);
+	//Blocks until the frame in flight is done, without starting another
+	void Flush();
+
+	//Stays valid and unchanged until the next Kick
+	RenderFrame* GetRenderFrame() { return &listFrame_[indexRender_]; }
+	//Duration of the simulation that produced the render frame, in ns
+	uint64_t GetSimulationTime() { return timeRender_; }
+};
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "pch.h"
+#include "Replay.hpp"
+#include "Utility.hpp"
+
+//*******************************************************************
+//Replay
+//*******************************************************************
+Replay::Replay() {
+	Reset(0U, 0U);
+}
+
+void Replay::Reset(uint32_t idScene, uint64_t seed) {
+	idScene_ = idScene;
+	seed_ = seed;
+	listInput_.clear();
+	listCheckpoint_.clear();
+}
+
+void Replay::Save(const std::string& path) {
+	std::vector<byte> data;
+	data.resize(64U + listInput_.size() * sizeof(InputState) + listCheckpoint_.size() * sizeof(Checkpoint));
+
+	{
+		SnapshotWriter writer(&data);
+		writer.Write(HEADER_MAGIC);
+		writer.Write(HEADER_VERSION);
+		writer.Write(idScene_);
+		writer.Write(seed_);
+		writer.WriteArray(listInput_);
+		writer.WriteArray(listCheckpoint_);
+	}
+
+	std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		throw EngineError(StringUtility::Format("Replay: Failed to open %s for writing.", path.c_str()));
+	stream.write((const char*)data.data(), data.size());
+}
+void Replay::Load(const std::string& path) {
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if (!stream.is_open())
+		throw EngineError(StringUtility::Format("Replay: Failed to open %s.", path.c_str()));
+	std::vector<byte> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+	SnapshotReader reader(data);
+	if (reader.Read<uint32_t>() != HEADER_MAGIC)
+		throw EngineError(StringUtility::Format("Replay: %s is not a replay file.", path.c_str()));
+	uint32_t version = reader.Read<uint32_t>();
+	if (version != HEADER_VERSION)
+		throw EngineError(StringUtility::Format("Replay: %s has unsupported version %u.", path.c_str(), version));
+	reader.Read(idScene_);
+	reader.Read(seed_);
+	reader.ReadArray(listInput_);
+	reader.ReadArray(listCheckpoint_);
+}
+
+uint64_t Replay::HashScene(Scene* scene, SceneSnapshot* scratch) {
+	scene->SaveSnapshot(scratch);
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (byte iByte : scratch->GetData()) {
+		hash ^= iByte;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "../../pch.h"
+
+#include "Input.hpp"
+#include "Scene.hpp"
+
+//*******************************************************************
+//Replay
+//	A scene run reduced to its seed and per-frame inputs, plus periodic
+//	hashes of the scene's snapshot to catch desyncs during playback.
+//*******************************************************************
+class Replay {
+public:
+	static constexpr uint32_t HEADER_MAGIC = 0x4c505250U;	//"PRPL"
+	static constexpr uint32_t HEADER_VERSION = 1U;
+	static constexpr uint64_t CHECKPOINT_INTERVAL = 60U;
+
+	struct Checkpoint {
+		uint64_t frame;
+		uint64_t hash;
+	};
+private:
+	uint32_t idScene_;	//Lets playback refuse replays of a different scene setup
+	uint64_t seed_;
+	std::vector<InputState> listInput_;
+	std::vector<Checkpoint> listCheckpoint_;
+public:
+	Replay();
+
+	void Reset(uint32_t idScene, uint64_t seed);
+
+	void AddFrame(const InputState& input) { listInput_.push_back(input); }
+	void AddCheckpoint(uint64_t frame, uint64_t hash) { listCheckpoint_.push_back(Checkpoint{ frame, hash }); }
+
+	void Save(const std::string& path);
+	void Load(const std::string& path);
+
+	uint32_t GetSceneID() { return idScene_; }
+	uint64_t GetSeed() { return seed_; }
+	size_t GetFrameCount() { return listInput_.size(); }
+	const InputState& GetInput(size_t frame) { return listInput_[frame]; }
+	const std::vector<Checkpoint>& GetCheckpoints() { return listCheckpoint_; }
+
+	//FNV-1a over the scene's snapshot; the scratch snapshot keeps its arena between calls
+	static uint64_t HashScene(Scene* scene, SceneSnapshot* scratch);
+};
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "DxConstant.hpp"
 #include "Utility.hpp"
+#include "Profiler.hpp"
 
 class ResourceManager;
 
@@ -144,6 +145,7 @@ public:
 	void AddResource(shared_ptr<Resource> resource, const std::string& path);
 	void RemoveResource(const std::string& path);
 	template<typename T> inline shared_ptr<T> LoadResource(const std::string& path, const std::string& name) {
+		PROFILE_ZONE("ResourceManager::LoadResource");
 		shared_ptr<T> res;
 		auto itrFind = mapResource_.find(name);
 		if (itrFind == mapResource_.end()) {
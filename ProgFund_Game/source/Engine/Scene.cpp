@@ -1,41 +1,359 @@
 #include "pch.h"
 #include "Utility.hpp"
 #include "Scene.hpp"
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+
+//Update order of the task currently running on this thread
+static thread_local uint64_t s_updateOrder = 0U;
 
 //*******************************************************************
 //Scene
 //*******************************************************************
 Scene::Scene() {
 	frame_ = 0U;
+	interpolation_ = 0.0f;
+	bUpdating_ = false;
+	bUpdatingParallel_ = false;
+	input_ = InputState{ 0U };
+	inputPrevious_ = InputState{ 0U };
+	sequenceNext_ = 0U;
+	listCommandBuffer_.resize(1U);
 }
 Scene::~Scene() {
+	for (TaskCommandBuffer& iBuffer : listCommandBuffer_) {
+		for (TaskCommandBuffer::Spawn& iSpawn : iBuffer.listSpawn_) {
+			iSpawn.task->handle_ = INVALID_TASK;
+			iSpawn.task->bSpawnPending_ = false;
+		}
+		iBuffer.Clear();
+	}
+	for (shared_ptr<TaskBase>& iTask : listTask_) {
+		iTask->handle_ = INVALID_TASK;
+		iTask->bAttached_ = false;
+	}
+	listTask_.Clear();
+	listActive_.clear();
+	listWake_.clear();
 }
 void Scene::Render() {
+	//Zones cover passes, not tasks: one event per task would wrap the profiler's rings within a frame
+	PROFILE_ZONE("Scene::Render");
 	for (shared_ptr<TaskBase>& iTask : listTask_) {
-		if (iTask && !iTask->IsFinished())
+		if (!iTask->IsFinished())
 			iTask->Render();
 	}
 }
+void Scene::GetRenderTasks(std::vector<shared_ptr<TaskBase>>* dst) {
+	dst->clear();
+	for (shared_ptr<TaskBase>& iTask : listTask_) {
+		if (!iTask->IsFinished())
+			dst->push_back(iTask);
+	}
+}
 void Scene::Update() {
-	for (auto itr = listTask_.begin(); itr != listTask_.end();) {
-		shared_ptr<TaskBase> task = *itr;
-		if (task && !task->IsFinished()) {
+	PROFILE_ZONE("Scene::Update");
+
+	wheelTask_.Advance(frame_, [&](uint64_t frame, const TaskTimer& timer) {
+		_OnTimer((size_t)frame, timer);
+	});
+
+	//Merge the woken tasks and drop the finished ones
+	_CompactTasks();
+
+	JobSystem* jobSystem = JobSystem::GetBase();
+	size_t countThread = jobSystem ? jobSystem->GetThreadCount() : 1U;
+	if (listCommandBuffer_.size() < countThread)
+		listCommandBuffer_.resize(countThread);
+
+	bUpdating_ = true;
+
+	//Thread-safe tasks always run first, even without workers, 
+	//	so the result doesn't depend on the thread count
+	listParallelTask_.clear();
+	for (TaskBase* task : listActive_) {
+		if (task->IsThreadSafe())
+			listParallelTask_.push_back(task);
+	}
+	if (listParallelTask_.size() > 0) {
+		//One zone per chunk, which also shows how the chunks spread over the threads
+		auto UpdateRange = [&](size_t begin, size_t end) {
+			PROFILE_ZONE("Scene::UpdateParallel");
+			for (size_t i = begin; i < end; ++i) {
+				s_updateOrder = i;
+				listParallelTask_[i]->Update();
+			}
+		};
+		bUpdatingParallel_ = true;
+		try {
+			if (jobSystem && listParallelTask_.size() >= PARALLEL_TASK_MIN)
+				jobSystem->ParallelFor(listParallelTask_.size(), PARALLEL_TASK_GRAIN, UpdateRange);
+			else
+				UpdateRange(0U, listParallelTask_.size());
+		}
+		catch (...) {
+			bUpdatingParallel_ = false;
+			throw;
+		}
+		bUpdatingParallel_ = false;
+	}
+
+	{
+		PROFILE_ZONE("Scene::UpdateSerial");
+		for (size_t i = 0; i < listActive_.size(); ++i) {
+			TaskBase* task = listActive_[i];
+			if (task->IsFinished() || task->IsThreadSafe()) continue;
+			s_updateOrder = listParallelTask_.size() + i;
 			task->Update();
-			if (task->GetFrame() >= task->GetFrameEnd())
-				task->bFinish_ = true;
-			++itr;
 		}
-		else itr = listTask_.erase(itr);
 	}
+
+	//End frames and suspensions are applied in task order after every update has run
+	size_t countAwake = 0U;
+	for (TaskBase* task : listActive_) {
+		if (task->bEndFrameDirty_) {
+			_ScheduleExpire(task);
+			task->bEndFrameDirty_ = false;
+		}
+		if (task->frameSuspend_ > 0U && !task->IsFinished()) {
+			_SleepTask(task, frame_ + 1U + task->frameSuspend_);
+			task->frameSuspend_ = 0U;
+			continue;
+		}
+		listActive_[countAwake++] = task;
+	}
+	listActive_.resize(countAwake);
+
+	bUpdating_ = false;
 	++frame_;
+
+	_FlushCommands();
+}
+
+RandomGenerator* Scene::GetRandom() {
+	if (bUpdatingParallel_)
+		throw EngineError("Scene: The random generator can't be used by thread-safe tasks.");
+	return &random_;
+}
+
+void Scene::SaveSnapshot(SceneSnapshot* snapshot) {
+	if (bUpdating_) throw EngineError("Scene: Snapshots can't be taken during Update.");
+	for (shared_ptr<TaskBase>& iTask : listTask_) {
+		if (!iTask->IsSnapshotSupported())
+			throw EngineError(StringUtility::Format("Scene: %s doesn't support snapshots.", typeid(*iTask).name()));
+	}
+
+	snapshot->frame_ = frame_;
+
+	SnapshotWriter writer(&snapshot->data_);
+	writer.Write(frame_);
+	writer.Write(sequenceNext_);
+	writer.Write(random_);
+	writer.Write(input_);
+	writer.Write(inputPrevious_);
+	listTask_.SerializeLayout(&writer);
+	wheelTask_.Serialize(&writer);
+
+	//References already held are kept, saving the refcount traffic of a full copy
+	size_t countTask = listTask_.GetSize();
+	snapshot->listTask_.resize(countTask);
+	for (size_t i = 0; i < countTask; ++i) {
+		if (snapshot->listTask_[i] != listTask_[i])
+			snapshot->listTask_[i] = listTask_[i];
+	}
+	for (shared_ptr<TaskBase>& iTask : listTask_) {
+		iTask->_SerializeBase(&writer);
+		iTask->Serialize(&writer);
+	}
+}
+void Scene::LoadSnapshot(SceneSnapshot* snapshot) {
+	if (bUpdating_) throw EngineError("Scene: Snapshots can't be loaded during Update.");
+
+	//Tasks added after the snapshot was taken are dropped
+	for (shared_ptr<TaskBase>& iTask : listTask_) {
+		iTask->handle_ = INVALID_TASK;
+		iTask->bAttached_ = false;
+	}
+
+	SnapshotReader reader(snapshot->data_);
+	reader.Read(frame_);
+	reader.Read(sequenceNext_);
+	reader.Read(random_);
+	reader.Read(input_);
+	reader.Read(inputPrevious_);
+	listTask_.RestoreLayout(&reader, snapshot->listTask_);
+	wheelTask_.Restore(&reader);
+
+	listActive_.clear();
+	listWake_.clear();
+	for (shared_ptr<TaskBase>& iTask : listTask_) {
+		iTask->_RestoreBase(&reader);
+		iTask->Restore(&reader);
+		iTask->bAttached_ = true;
+		if (!iTask->bSleep_)
+			listActive_.push_back(iTask.get());
+	}
 }
-std::list<shared_ptr<TaskBase>>::iterator Scene::AddTask(shared_ptr<TaskBase> task) {
-	listTask_.push_back(task);
-	return listTask_.rbegin().base();
+
+TaskHandle Scene::AddTask(shared_ptr<TaskBase> task) {
+	if (task == nullptr) return INVALID_TASK;
+	if (task->handle_ != INVALID_TASK || task->bSpawnPending_) return task->handle_;
+
+	if (!bUpdating_) {
+		TaskHandle handle = listTask_.Allocate();
+		_InsertTask(handle, std::move(task));
+		return handle;
+	}
+
+	//Threads of the parallel pass get here in any order, so their handles would depend on timing
+	TaskHandle handle = bUpdatingParallel_ ? INVALID_TASK : listTask_.Allocate();
+	task->handle_ = handle;
+	task->bSpawnPending_ = true;
+
+	size_t iThread = std::min(JobSystem::GetThreadIndex(), listCommandBuffer_.size() - 1U);
+	listCommandBuffer_[iThread].listSpawn_.push_back(
+		TaskCommandBuffer::Spawn{ s_updateOrder, handle, std::move(task) });
+	return handle;
+}
+void Scene::RemoveTask(TaskHandle handle) {
+	if (!bUpdating_) {
+		_KillTask(handle);
+		return;
+	}
+	size_t iThread = std::min(JobSystem::GetThreadIndex(), listCommandBuffer_.size() - 1U);
+	listCommandBuffer_[iThread].listKill_.push_back(TaskCommandBuffer::Kill{ s_updateOrder, handle });
+}
+bool Scene::IsTaskValid(TaskHandle handle) {
+	if (bUpdatingParallel_)
+		throw EngineError("Scene: Tasks can't be looked up by thread-safe tasks.");
+	return listTask_.IsValid(handle);
+}
+shared_ptr<TaskBase> Scene::GetTask(TaskHandle handle) {
+	if (bUpdatingParallel_)
+		throw EngineError("Scene: Tasks can't be looked up by thread-safe tasks.");
+	shared_ptr<TaskBase>* pTask = listTask_.Get(handle);
+	return pTask ? *pTask : nullptr;
+}
+
+void Scene::_InsertTask(TaskHandle handle, shared_ptr<TaskBase>&& task) {
+	TaskBase* pTask = task.get();
+	listTask_.Assign(handle, std::move(task));
+	listActive_.push_back(pTask);
+
+	pTask->handle_ = handle;
+	pTask->bAttached_ = true;
+	pTask->bSpawnPending_ = false;
+	pTask->sequence_ = sequenceNext_++;
+	pTask->frameStart_ = frame_;
+	pTask->bSleep_ = false;
+	_ScheduleExpire(pTask);
+}
+void Scene::_KillTask(TaskHandle handle) {
+	if (shared_ptr<TaskBase>* pTask = listTask_.Get(handle)) {
+		(*pTask)->bFinish_ = true;
+		_WakeTask(handle);
+	}
+}
+void Scene::_CompactTasks() {
+	//Woken tasks rejoin the awake ones in insertion order
+	if (listWake_.size() > 0) {
+		auto CompareSequence = [](TaskBase* a, TaskBase* b) { return a->sequence_ < b->sequence_; };
+		std::sort(listWake_.begin(), listWake_.end(), CompareSequence);
+		listActiveMerge_.clear();
+		std::merge(listActive_.begin(), listActive_.end(), listWake_.begin(), listWake_.end(),
+			std::back_inserter(listActiveMerge_), CompareSequence);
+		listActive_.swap(listActiveMerge_);
+		listWake_.clear();
+	}
+
+	//Finished tasks are all awake by now, sleeping ones are woken when they finish
+	size_t countKeep = 0U;
+	for (TaskBase* task : listActive_) {
+		if (!task->IsFinished())
+			listActive_[countKeep++] = task;
+	}
+	if (countKeep == listActive_.size()) return;
+	listActive_.resize(countKeep);
+
+	listTask_.EraseIf([](shared_ptr<TaskBase>& task) {
+		if (!task->IsFinished()) return false;
+		task->handle_ = INVALID_TASK;
+		task->bAttached_ = false;
+		return true;
+	});
+}
+void Scene::_FlushCommands() {
+	PROFILE_ZONE("Scene::FlushCommands");
+	auto CompareOrder = [](const auto& a, const auto& b) { return a.order < b.order; };
+
+	listSpawnMerge_.clear();
+	listKillMerge_.clear();
+	for (TaskCommandBuffer& iBuffer : listCommandBuffer_) {
+		for (TaskCommandBuffer::Spawn& iSpawn : iBuffer.listSpawn_)
+			listSpawnMerge_.push_back(std::move(iSpawn));
+		listKillMerge_.insert(listKillMerge_.end(), iBuffer.listKill_.begin(), iBuffer.listKill_.end());
+		iBuffer.Clear();
+	}
+
+	//Commands from one task come from one thread and are already in call order
+	if (!std::is_sorted(listSpawnMerge_.begin(), listSpawnMerge_.end(), CompareOrder))
+		std::stable_sort(listSpawnMerge_.begin(), listSpawnMerge_.end(), CompareOrder);
+	if (!std::is_sorted(listKillMerge_.begin(), listKillMerge_.end(), CompareOrder))
+		std::stable_sort(listKillMerge_.begin(), listKillMerge_.end(), CompareOrder);
+
+	if (listSpawnMerge_.size() > 0) {
+		size_t sizeRequired = listTask_.GetSize() + listSpawnMerge_.size();
+		if (sizeRequired > listTask_.GetCapacity())
+			listTask_.Reserve(std::max(sizeRequired, listTask_.GetCapacity() * 2U));
+
+		for (TaskCommandBuffer::Spawn& iSpawn : listSpawnMerge_) {
+			if (iSpawn.handle == INVALID_TASK)
+				iSpawn.handle = listTask_.Allocate();
+			_InsertTask(iSpawn.handle, std::move(iSpawn.task));
+		}
+		listSpawnMerge_.clear();
+	}
+
+	//After the spawns, so tasks spawned and killed in the same frame are removed as well
+	for (TaskCommandBuffer::Kill& iKill : listKillMerge_)
+		_KillTask(iKill.handle);
+	listKillMerge_.clear();
+}
+
+void Scene::_SleepTask(TaskBase* task, size_t frameWake) {
+	task->bSleep_ = true;
+	task->frameWake_ = frameWake;
+	wheelTask_.Schedule(frameWake, TaskTimer{ task->handle_, TaskTimer::Type::Wake });
+}
+void Scene::_WakeTask(TaskHandle handle) {
+	shared_ptr<TaskBase>* pTask = listTask_.Get(handle);
+	if (pTask == nullptr || !(*pTask)->bSleep_) return;
+
+	(*pTask)->bSleep_ = false;
+	listWake_.push_back(pTask->get());
+}
+void Scene::_ScheduleExpire(TaskBase* task) {
+	if (task->frameEnd_ == UINT_MAX) return;
+	wheelTask_.Schedule(task->frameStart_ + task->frameEnd_, TaskTimer{ task->handle_, TaskTimer::Type::Expire });
 }
-std::list<shared_ptr<TaskBase>>::iterator Scene::AddTask(std::list<shared_ptr<TaskBase>>::iterator itr, shared_ptr<TaskBase> task) {
-	auto itrRes = listTask_.insert(itr, task);
-	return itrRes;
+void Scene::_OnTimer(size_t frame, const TaskTimer& timer) {
+	shared_ptr<TaskBase>* pTask = listTask_.Get(timer.handle);
+	if (pTask == nullptr) return;
+	TaskBase* task = pTask->get();
+
+	//Timers are never cancelled, stale ones are recognized and ignored here
+	switch (timer.type) {
+	case TaskTimer::Type::Wake:
+		if (task->bSleep_ && task->frameWake_ == frame)
+			_WakeTask(timer.handle);
+		break;
+	case TaskTimer::Type::Expire:
+		if (task->frameEnd_ != UINT_MAX && task->frameStart_ + task->frameEnd_ == frame) {
+			task->bFinish_ = true;
+			_WakeTask(timer.handle);
+		}
+		break;
+	}
 }
 
 //*******************************************************************
@@ -43,7 +361,61 @@ std::list<shared_ptr<TaskBase>>::iterator Scene::AddTask(std::list<shared_ptr<Ta
 //*******************************************************************
 TaskBase::TaskBase(Scene* parent) {
 	parent_ = parent;
-	frame_ = 0;
+	handle_ = INVALID_TASK;
+	sequence_ = 0U;
+	frameStart_ = 0U;
 	frameEnd_ = UINT_MAX;
+	frameSuspend_ = 0U;
+	frameWake_ = 0U;
 	bFinish_ = false;
+	bThreadSafe_ = false;
+	bSleep_ = false;
+	bEndFrameDirty_ = false;
+	bAttached_ = false;
+	bSpawnPending_ = false;
+}
+
+SizeClassPool* TaskBase::GetPool() {
+	//Never destroyed, tasks held by other statics may still be released after it would have been
+	static SizeClassPool* pool = new SizeClassPool();
+	return pool;
+}
+
+void TaskBase::_SerializeBase(SnapshotWriter* writer) {
+	writer->Write(handle_);
+	writer->Write(sequence_);
+	writer->Write(frameStart_);
+	writer->Write(frameEnd_);
+	writer->Write(frameSuspend_);
+	writer->Write(frameWake_);
+	writer->Write(bFinish_);
+	writer->Write(bSleep_);
+}
+void TaskBase::_RestoreBase(SnapshotReader* reader) {
+	reader->Read(handle_);
+	reader->Read(sequence_);
+	reader->Read(frameStart_);
+	reader->Read(frameEnd_);
+	reader->Read(frameSuspend_);
+	reader->Read(frameWake_);
+	reader->Read(bFinish_);
+	reader->Read(bSleep_);
+	bEndFrameDirty_ = false;
+}
+
+void TaskBase::SetEndFrame(size_t frame) {
+	frameEnd_ = frame;
+	//Not the slot map: a task running in parallel may not look it up, and knows whether it was added
+	if (parent_ == nullptr || !bAttached_) return;
+	//The timer wheel isn't touched while tasks may be running in parallel. Those can only change
+	//	their own end frame, and being awake they are all seen by the end of the update pass.
+	//	Anything else, including sleeping tasks changed by others, is scheduled right away.
+	if (parent_->bUpdatingParallel_)
+		bEndFrameDirty_ = true;
+	else
+		parent_->_ScheduleExpire(this);
+}
+size_t TaskBase::GetFrame() {
+	if (parent_ == nullptr || !bAttached_) return 0U;
+	return parent_->GetFrame() - frameStart_;
 }
\ No newline at end of file
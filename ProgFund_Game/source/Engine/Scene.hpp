@@ -1,31 +1,164 @@
 #pragma once
 #include "../../pch.h"
 
+#include "SlotMap.hpp"
+#include "TimingWheel.hpp"
+#include "MemoryPool.hpp"
+#include "Input.hpp"
+#include "Random.hpp"
+
 class Scene;
+class SceneSnapshot;
+class TaskBase;
+class RenderFrame;
+
+typedef SlotMap<shared_ptr<TaskBase>>::Handle TaskHandle;
+constexpr TaskHandle INVALID_TASK = SlotMap<shared_ptr<TaskBase>>::INVALID_HANDLE;
+
 class TaskBase {
 	friend class Scene;
 public:
 	TaskBase(Scene* parent);
 	virtual ~TaskBase() {};
 
+	//Task and shared_ptr control block in one pool block instead of two heap allocations
+	template<class T, typename... Args>
+	static shared_ptr<T> Create(Args&&... args) {
+		static_assert(std::is_base_of<TaskBase, T>::value, "T must derive from TaskBase");
+		return std::allocate_shared<T>(PoolAllocator<T>(GetPool()), std::forward<Args>(args)...);
+	}
+	static SizeClassPool* GetPool();
+
 	virtual void Render() {};
 	virtual void Update() {};
+	//Pipelined counterpart of Render: runs on the simulation thread and may
+	//	only record into the frame, the device belongs to the render thread
+	virtual void Extract(RenderFrame* frame) {};
+
+	//Opt-in for snapshots; state not written here is left as is on restore
+	virtual void Serialize(SnapshotWriter* writer) {}
+	virtual void Restore(SnapshotReader* reader) {}
+	//Tasks whose state can't be written, such as a suspended coroutine, make SaveSnapshot throw
+	virtual bool IsSnapshotSupported() { return true; }
 
 	Scene* GetParent() { return parent_; }
+	TaskHandle GetHandle() { return handle_; }
 
-	void SetEndFrame(size_t frame) { frameEnd_ = frame; }
+	//Thread-safe tasks may be updated in parallel and must only touch their own state
+	bool IsThreadSafe() { return bThreadSafe_; }
 
-	size_t GetFrame() { return frame_; }
+	//Skips the next n updates, applied after the current update pass
+	void Suspend(size_t frames) { frameSuspend_ = frames; }
+	bool IsSleeping() { return bSleep_; }
+
+	//The task finishes once it has been alive for this many frames
+	void SetEndFrame(size_t frame);
+
+	//Frames since the task was added to the scene
+	size_t GetFrame();
 	size_t GetFrameEnd() { return frameEnd_; }
 	bool IsFinished() { return bFinish_; }
 protected:
 	Scene* parent_;
-	size_t frame_;
+	TaskHandle handle_;
+	uint64_t sequence_;		//Insertion order, which updates and renders follow
+	size_t frameStart_;
 	size_t frameEnd_;
+	size_t frameSuspend_;
+	size_t frameWake_;
 	bool bFinish_;
+	bool bThreadSafe_;
+	bool bSleep_;
+	bool bEndFrameDirty_;
+	bool bAttached_;		//Owned by the scene's slot map, set and cleared by the scene thread only
+	bool bSpawnPending_;	//Queued by AddTask during Update, not yet in the slot map
+
+	void _SerializeBase(SnapshotWriter* writer);
+	void _RestoreBase(SnapshotReader* reader);
+};
+
+//*******************************************************************
+//TaskCommandBuffer
+//	Spawns and kills recorded during Scene::Update, one buffer per thread.
+//*******************************************************************
+class TaskCommandBuffer {
+	friend class Scene;
+public:
+	static constexpr size_t INITIAL_CAPACITY = 4096U;
+
+	//order: update order of the issuing task, keeps the flush deterministic
+	//handle: INVALID_TASK for spawns from the parallel pass, allocated by the flush
+	struct Spawn {
+		uint64_t order;
+		TaskHandle handle;
+		shared_ptr<TaskBase> task;
+	};
+	struct Kill {
+		uint64_t order;
+		TaskHandle handle;
+	};
+private:
+	std::vector<Spawn> listSpawn_;
+	std::vector<Kill> listKill_;
+public:
+	TaskCommandBuffer() {
+		listSpawn_.reserve(INITIAL_CAPACITY);
+		listKill_.reserve(INITIAL_CAPACITY);
+	}
+
+	//Capacity is kept between frames
+	void Clear() {
+		listSpawn_.clear();
+		listKill_.clear();
+	}
+	bool IsEmpty() { return listSpawn_.empty() && listKill_.empty(); }
+};
+
+//*******************************************************************
+//SceneSnapshot
+//	Simulation state of a Scene at a frame boundary. Holds references to
+//	its tasks so ones removed since can be brought back.
+//*******************************************************************
+class SceneSnapshot {
+	friend class Scene;
+private:
+	size_t frame_;
+	std::vector<byte> data_;
+	std::vector<shared_ptr<TaskBase>> listTask_;
+public:
+	SceneSnapshot() : frame_(0U) {}
+
+	void Reserve(size_t sizeData, size_t countTask) {
+		data_.reserve(sizeData);
+		listTask_.reserve(countTask);
+	}
+	void Clear() {
+		data_.clear();
+		listTask_.clear();
+	}
+
+	size_t GetFrame() { return frame_; }
+	const std::vector<byte>& GetData() { return data_; }
+	size_t GetDataSize() { return data_.size(); }
+	size_t GetTaskCount() { return listTask_.size(); }
 };
 
 class Scene {
+	friend class TaskBase;
+public:
+	static constexpr size_t PARALLEL_TASK_GRAIN = 64U;
+	//Below this many thread-safe tasks, waking the workers costs more than it saves
+	static constexpr size_t PARALLEL_TASK_MIN = 4096U;
+
+	//No padding bytes, snapshots get hashed byte for byte
+	struct TaskTimer {
+		enum class Type : uint32_t {
+			Wake,
+			Expire,
+		};
+		TaskHandle handle;
+		Type type;
+	};
 public:
 	Scene();
 	virtual ~Scene();
@@ -35,11 +168,76 @@ public:
 
 	size_t GetFrame() { return frame_; }
 
-	size_t GetTaskCount() { return listTask_.size(); }
+	//Fraction of an update elapsed since the last one, for rendering between updates
+	void SetInterpolation(float alpha) { interpolation_ = alpha; }
+	float GetInterpolation() { return interpolation_; }
+
+	//Applies to the next Update; the previous state is kept for press detection
+	void SetInput(const InputState& input) {
+		inputPrevious_ = input_;
+		input_ = input;
+	}
+	const InputState& GetInput() { return input_; }
+	bool IsKeyHeld(VirtualKey key) { return input_.IsHeld(key); }
+	bool IsKeyPressed(VirtualKey key) { return input_.IsHeld(key) && !inputPrevious_.IsHeld(key); }
+
+	//Draws are only deterministic in task order, so thread-safe tasks can't use this
+	RandomGenerator* GetRandom();
+	void SetSeed(uint64_t seed) { random_.SetSeed(seed); }
 
-	std::list<shared_ptr<TaskBase>>::iterator AddTask(shared_ptr<TaskBase> task);
-	std::list<shared_ptr<TaskBase>>::iterator AddTask(std::list<shared_ptr<TaskBase>>::iterator itr, shared_ptr<TaskBase> task);
+	//Tasks to be drawn this frame, in render order
+	void GetRenderTasks(std::vector<shared_ptr<TaskBase>>* dst);
+
+	//Only valid between updates. Throws if a task doesn't support snapshots.
+	void SaveSnapshot(SceneSnapshot* snapshot);
+	void LoadSnapshot(SceneSnapshot* snapshot);
+
+	size_t GetTaskCount() { return listTask_.GetSize(); }
+	size_t GetActiveTaskCount() { return listActive_.size(); }
+
+	//During Update the task is only queued, and joins the scene at the end of the frame.
+	//	The returned handle becomes valid at that point. Thread-safe tasks get INVALID_TASK,
+	//	their spawns are given handles by the flush, in update order, so replays match.
+	TaskHandle AddTask(shared_ptr<TaskBase> task);
+	//The task is flagged as finished and removed on the next Update
+	void RemoveTask(TaskHandle handle);
+
+	//Thread-safe tasks may only touch their own state, so they can't look up others
+	bool IsTaskValid(TaskHandle handle);
+	shared_ptr<TaskBase> GetTask(TaskHandle handle);
 protected:
 	size_t frame_;
-	std::list<shared_ptr<TaskBase>> listTask_;
+	float interpolation_;
+	bool bUpdating_;
+	bool bUpdatingParallel_;
+
+	InputState input_;
+	InputState inputPrevious_;
+	RandomGenerator random_;
+
+	//Every task in insertion order; the awake ones are also listed in that order, so
+	//	sleeping and waking never reorder the update or the render
+	SlotMap<shared_ptr<TaskBase>> listTask_;
+	uint64_t sequenceNext_;
+	std::vector<TaskBase*> listActive_;
+	std::vector<TaskBase*> listWake_;		//Woken since the last compaction
+	std::vector<TaskBase*> listActiveMerge_;
+	std::vector<TaskBase*> listParallelTask_;
+
+	//Sleeping tasks and end frames are parked here instead of being polled
+	TimingWheel<TaskTimer> wheelTask_;
+
+	std::vector<TaskCommandBuffer> listCommandBuffer_;
+	std::vector<TaskCommandBuffer::Spawn> listSpawnMerge_;
+	std::vector<TaskCommandBuffer::Kill> listKillMerge_;
+
+	void _InsertTask(TaskHandle handle, shared_ptr<TaskBase>&& task);
+	void _KillTask(TaskHandle handle);
+	void _CompactTasks();
+	void _FlushCommands();
+
+	void _SleepTask(TaskBase* task, size_t frameWake);
+	void _WakeTask(TaskHandle handle);
+	void _ScheduleExpire(TaskBase* task);
+	void _OnTimer(size_t frame, const TaskTimer& timer);
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "pch.h"
+#include "Simd.hpp"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+//*******************************************************************
+//CpuFeature
+//*******************************************************************
+static SimdLevel _DetectSimdLevel() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	int countLeaf = info[0];
+
+	__cpuid(info, 1);
+	if ((info[3] & (1 << 26)) == 0) return SimdLevel::Scalar;
+
+	//AVX also needs the OS to save the YMM registers
+	bool bOSXSave = (info[2] & (1 << 27)) != 0;
+	bool bAVX = (info[2] & (1 << 28)) != 0;
+	if (!bOSXSave || !bAVX || (_xgetbv(0) & 0x6) != 0x6) return SimdLevel::SSE2;
+
+	if (countLeaf >= 7) {
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5)) return SimdLevel::AVX2;
+	}
+	return SimdLevel::AVX;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+	if (__builtin_cpu_supports("avx")) return SimdLevel::AVX;
+	if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+	return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel CpuFeature::GetSimdLevel() {
+	static const SimdLevel level = _DetectSimdLevel();
+	return level;
+}
+const char* CpuFeature::GetName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Scalar: return "Scalar";
+	case SimdLevel::SSE2: return "SSE2";
+	case SimdLevel::AVX: return "AVX";
+	case SimdLevel::AVX2: return "AVX2";
+	}
+	return "Scalar";
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include "../../pch.h"
+
+//Kernels using more than the build's baseline (SSE2) are tagged with these and only
+//	called once CpuFeature reports support. MSVC compiles any intrinsic without a flag.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET_AVX
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+enum class SimdLevel : uint8_t {
+	Scalar,
+	SSE2,
+	AVX,
+	AVX2,
+};
+
+//*******************************************************************
+//CpuFeature
+//*******************************************************************
+class CpuFeature {
+public:
+	//Highest level the CPU and OS support, detected once
+	static SimdLevel GetSimdLevel();
+	//Clamps a requested level to what's supported
+	static SimdLevel Resolve(SimdLevel level) { return std::min(level, GetSimdLevel()); }
+
+	static const char* GetName(SimdLevel level);
+};
\ No newline at end of file
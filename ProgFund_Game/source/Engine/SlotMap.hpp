@@ -0,0 +1,212 @@
+#pragma once
+#include "../../pch.h"
+
+#include "Utility.hpp"
+#include "Snapshot.hpp"
+
+//*******************************************************************
+//SlotMap
+//	Contiguous storage with stable, generation-checked 32-bit handles.
+//	Handle layout: [generation:12][index:20]
+//	Freed slots are reused oldest first. A slot whose generation is spent is
+//	retired instead of wrapping, so a stale handle can never match again.
+//*******************************************************************
+template<typename T>
+class SlotMap {
+public:
+	typedef uint32_t Handle;
+
+	static constexpr uint32_t INDEX_BITS = 20U;
+	static constexpr uint32_t INDEX_MASK = (1U << INDEX_BITS) - 1U;
+	static constexpr uint32_t GENERATION_MASK = (1U << (32U - INDEX_BITS)) - 1U;
+	static constexpr Handle INVALID_HANDLE = 0xffffffffU;
+
+	//The last slot index is never handed out, so INVALID_HANDLE can never resolve
+	static constexpr size_t MAX_SIZE = INDEX_MASK;
+private:
+	static constexpr uint32_t FREE_END = 0xffffffffU;
+	static constexpr uint32_t FREE = 0xffffffffU;
+	static constexpr uint32_t PENDING = 0xfffffffeU;
+
+	struct Slot {
+		uint32_t index;			//Dense index while alive, PENDING while allocated, FREE otherwise
+		uint32_t next;			//Next free slot while in the free list
+		uint32_t generation;
+	};
+
+	std::vector<T> dense_;
+	std::vector<uint32_t> listDenseSlot_;	//Dense index -> slot index
+	std::vector<Slot> listSlot_;
+	uint32_t freeHead_;
+	uint32_t freeTail_;
+
+	void _PushFree(uint32_t iSlot) {
+		Slot& slot = listSlot_[iSlot];
+		slot.index = FREE;
+		slot.next = FREE_END;
+		//Retired: the next generation would wrap around to handles that were already given out
+		if (slot.generation == GENERATION_MASK) return;
+
+		++slot.generation;
+		if (freeTail_ != FREE_END)
+			listSlot_[freeTail_].next = iSlot;
+		else
+			freeHead_ = iSlot;
+		freeTail_ = iSlot;
+	}
+public:
+	SlotMap() {
+		freeHead_ = FREE_END;
+		freeTail_ = FREE_END;
+	}
+
+	static inline uint32_t GetIndex(Handle handle) { return handle & INDEX_MASK; }
+	static inline uint32_t GetGeneration(Handle handle) { return handle >> INDEX_BITS; }
+	static inline Handle MakeHandle(uint32_t index, uint32_t generation) {
+		return ((generation & GENERATION_MASK) << INDEX_BITS) | (index & INDEX_MASK);
+	}
+
+	void Reserve(size_t count) {
+		dense_.reserve(count);
+		listDenseSlot_.reserve(count);
+		listSlot_.reserve(count);
+	}
+	void Clear() {
+		dense_.clear();
+		listDenseSlot_.clear();
+		listSlot_.clear();
+		freeHead_ = FREE_END;
+		freeTail_ = FREE_END;
+	}
+
+	size_t GetCapacity() const { return dense_.capacity(); }
+
+	//Hands out a handle that stays invalid until a value is assigned to it
+	Handle Allocate() {
+		uint32_t iSlot;
+		if (freeHead_ != FREE_END) {
+			iSlot = freeHead_;
+			freeHead_ = listSlot_[iSlot].next;
+			if (freeHead_ == FREE_END)
+				freeTail_ = FREE_END;
+		}
+		else {
+			if (listSlot_.size() >= MAX_SIZE)
+				throw EngineError("SlotMap: Capacity exceeded.");
+			iSlot = (uint32_t)listSlot_.size();
+			listSlot_.push_back(Slot{ FREE, FREE_END, 0U });
+		}
+
+		Slot& slot = listSlot_[iSlot];
+		slot.index = PENDING;
+		return MakeHandle(iSlot, slot.generation);
+	}
+	//Appends the value for a handle returned by Allocate
+	void Assign(Handle handle, T&& value) {
+		uint32_t iSlot = GetIndex(handle);
+		Slot& slot = listSlot_[iSlot];
+		if (slot.index != PENDING || slot.generation != GetGeneration(handle))
+			throw EngineError("SlotMap: Assigning to a handle that is not pending.");
+		slot.index = (uint32_t)dense_.size();
+		dense_.push_back(std::move(value));
+		listDenseSlot_.push_back(iSlot);
+	}
+
+	Handle Insert(const T& value) {
+		return Insert(T(value));
+	}
+	Handle Insert(T&& value) {
+		Handle handle = Allocate();
+		Assign(handle, std::move(value));
+		return handle;
+	}
+
+	//Swap-and-pop; the last element is moved into the hole
+	void EraseAt(size_t denseIndex) {
+		uint32_t iSlot = listDenseSlot_[denseIndex];
+		size_t last = dense_.size() - 1U;
+		if (denseIndex != last) {
+			dense_[denseIndex] = std::move(dense_[last]);
+			listDenseSlot_[denseIndex] = listDenseSlot_[last];
+			listSlot_[listDenseSlot_[denseIndex]].index = (uint32_t)denseIndex;
+		}
+		dense_.pop_back();
+		listDenseSlot_.pop_back();
+
+		_PushFree(iSlot);
+	}
+	//Stable: erases the values pred accepts, the others keep their order
+	template<class Pred>
+	size_t EraseIf(Pred pred) {
+		size_t size = dense_.size();
+		size_t iWrite = 0U;
+		for (size_t i = 0; i < size; ++i) {
+			if (pred(dense_[i])) {
+				_PushFree(listDenseSlot_[i]);
+				continue;
+			}
+			if (iWrite != i) {
+				dense_[iWrite] = std::move(dense_[i]);
+				listDenseSlot_[iWrite] = listDenseSlot_[i];
+				listSlot_[listDenseSlot_[iWrite]].index = (uint32_t)iWrite;
+			}
+			++iWrite;
+		}
+		dense_.erase(dense_.begin() + iWrite, dense_.end());
+		listDenseSlot_.resize(iWrite);
+		return size - iWrite;
+	}
+	bool Erase(Handle handle) {
+		size_t denseIndex = GetDenseIndex(handle);
+		if (denseIndex == SIZE_MAX) return false;
+		EraseAt(denseIndex);
+		return true;
+	}
+
+	//Returns SIZE_MAX for stale or invalid handles
+	size_t GetDenseIndex(Handle handle) const {
+		uint32_t iSlot = GetIndex(handle);
+		if (iSlot >= listSlot_.size()) return SIZE_MAX;
+		const Slot& slot = listSlot_[iSlot];
+		if (slot.generation != GetGeneration(handle) || slot.index == PENDING || slot.index == FREE) return SIZE_MAX;
+		return slot.index;
+	}
+	bool IsValid(Handle handle) const { return GetDenseIndex(handle) != SIZE_MAX; }
+
+	T* Get(Handle handle) {
+		size_t denseIndex = GetDenseIndex(handle);
+		return denseIndex != SIZE_MAX ? &dense_[denseIndex] : nullptr;
+	}
+	Handle GetHandleAt(size_t denseIndex) const {
+		uint32_t iSlot = listDenseSlot_[denseIndex];
+		return MakeHandle(iSlot, listSlot_[iSlot].generation);
+	}
+
+	//Slot bookkeeping only; the values are saved by the owner
+	void SerializeLayout(SnapshotWriter* writer) const {
+		writer->WriteArray(listDenseSlot_);
+		writer->WriteArray(listSlot_);
+		writer->Write(freeHead_);
+		writer->Write(freeTail_);
+	}
+	void RestoreLayout(SnapshotReader* reader, const std::vector<T>& dense) {
+		reader->ReadArray(listDenseSlot_);
+		reader->ReadArray(listSlot_);
+		reader->Read(freeHead_);
+		reader->Read(freeTail_);
+		if (listDenseSlot_.size() != dense.size())
+			throw EngineError("SlotMap: Snapshot layout does not match its values.");
+		dense_.assign(dense.begin(), dense.end());
+	}
+
+	size_t GetSize() const { return dense_.size(); }
+	bool IsEmpty() const { return dense_.empty(); }
+
+	T& operator[](size_t denseIndex) { return dense_[denseIndex]; }
+	const T& operator[](size_t denseIndex) const { return dense_[denseIndex]; }
+
+	typename std::vector<T>::iterator begin() { return dense_.begin(); }
+	typename std::vector<T>::iterator end() { return dense_.end(); }
+	typename std::vector<T>::const_iterator begin() const { return dense_.begin(); }
+	typename std::vector<T>::const_iterator end() const { return dense_.end(); }
+};
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "../../pch.h"
+
+#include "Utility.hpp"
+
+//*******************************************************************
+//SnapshotWriter
+//	Writes raw POD blocks into a byte arena from its start, over what it held
+//	before. The arena only grows, geometrically, when a write passes its end,
+//	and is cut to the written size when the writer is destroyed, so once it
+//	has been sized for a scene saving is mostly memcpy.
+//	Padding is copied as is, so types in hashed snapshots shouldn't have any.
+//*******************************************************************
+class SnapshotWriter {
+	static constexpr size_t MIN_CAPACITY = 256U;
+private:
+	std::vector<byte>* buffer_;
+	size_t pos_;
+public:
+	SnapshotWriter(std::vector<byte>* buffer) : buffer_(buffer), pos_(0U) {}
+	~SnapshotWriter() { buffer_->resize(pos_); }
+
+	void Write(const void* data, size_t size) {
+		if (pos_ + size > buffer_->size())
+			buffer_->resize(std::max(pos_ + size, std::max(buffer_->size() * 2U, MIN_CAPACITY)));
+		memcpy(buffer_->data() + pos_, data, size);
+		pos_ += size;
+	}
+	template<typename T>
+	void Write(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+		Write(&value, sizeof(T));
+	}
+	template<typename T>
+	void WriteArray(const std::vector<T>& values) {
+		static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+		Write<uint32_t>((uint32_t)values.size());
+		if (values.size() > 0)
+			Write(values.data(), values.size() * sizeof(T));
+	}
+
+	size_t GetSize() { return pos_; }
+};
+
+//*******************************************************************
+//SnapshotReader
+//*******************************************************************
+class SnapshotReader {
+private:
+	const byte* data_;
+	size_t size_;
+	size_t pos_;
+public:
+	SnapshotReader(const std::vector<byte>& buffer) : data_(buffer.data()), size_(buffer.size()), pos_(0U) {}
+	SnapshotReader(const byte* data, size_t size) : data_(data), size_(size), pos_(0U) {}
+
+	void Read(void* data, size_t size) {
+		if (pos_ + size > size_)
+			throw EngineError("SnapshotReader: Read past the end of the snapshot.");
+		memcpy(data, data_ + pos_, size);
+		pos_ += size;
+	}
+	template<typename T>
+	void Read(T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+		Read(&value, sizeof(T));
+	}
+	template<typename T>
+	T Read() {
+		T value;
+		Read(value);
+		return value;
+	}
+	template<typename T>
+	void ReadArray(std::vector<T>& values) {
+		static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+		values.resize(Read<uint32_t>());
+		if (values.size() > 0)
+			Read(values.data(), values.size() * sizeof(T));
+	}
+
+	size_t GetPosition() { return pos_; }
+	bool IsEnd() { return pos_ >= size_; }
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "Utility.hpp"
+#include "MemoryPool.hpp"
+#include "TaskCoroutine.hpp"
+
+//*******************************************************************
+//Coroutine
+//*******************************************************************
+SizeClassPool* Coroutine::GetPool() {
+	//Never destroyed, like the task pool: frames owned by tasks may outlive it otherwise
+	static SizeClassPool* pool = new SizeClassPool();
+	return pool;
+}
+
+void* Coroutine::promise_type::operator new(size_t size) {
+	return GetPool()->Allocate(size);
+}
+void Coroutine::promise_type::operator delete(void* ptr, size_t size) {
+	GetPool()->Deallocate(ptr, size);
+}
+
+Coroutine& Coroutine::operator=(Coroutine&& other) noexcept {
+	if (this != &other) {
+		if (handle_) handle_.destroy();
+		handle_ = other.handle_;
+		other.handle_ = nullptr;
+	}
+	return *this;
+}
+Coroutine::~Coroutine() {
+	if (handle_) handle_.destroy();
+}
+
+size_t Coroutine::Resume() {
+	if (IsDone()) return 0U;
+
+	promise_type& promise = handle_.promise();
+	promise.frameWait = 0U;
+	handle_.resume();
+	if (promise.pError) {
+		std::exception_ptr pError = promise.pError;
+		promise.pError = nullptr;
+		std::rethrow_exception(pError);
+	}
+	return promise.frameWait;
+}
+
+//*******************************************************************
+//CoroutineTask
+//*******************************************************************
+CoroutineTask::CoroutineTask(Scene* parent, Coroutine&& routine) : TaskBase(parent) {
+	routine_ = std::move(routine);
+}
+CoroutineTask::~CoroutineTask() {
+}
+
+void CoroutineTask::Update() {
+	size_t frameWait = routine_.Resume();
+	if (routine_.IsDone()) {
+		bFinish_ = true;
+		return;
+	}
+	//Waiting one frame only means being resumed next update
+	if (frameWait > 1U)
+		Suspend(frameWait - 1U);
+}
\ No newline at end of file
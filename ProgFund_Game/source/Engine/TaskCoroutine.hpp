@@ -0,0 +1,82 @@
+#pragma once
+#include "../../pch.h"
+
+#include <coroutine>
+
+#include "Scene.hpp"
+
+//*******************************************************************
+//Coroutine
+//	Return type for task coroutines, e.g.
+//		Coroutine Pattern(Scene* scene) {
+//			while (true) {
+//				Fire();
+//				co_await WaitFrames(10);
+//			}
+//		}
+//	Frames are allocated from a shared SizeClassPool.
+//*******************************************************************
+class Coroutine {
+public:
+	struct promise_type {
+		size_t frameWait = 0U;
+		std::exception_ptr pError = nullptr;
+
+		static void* operator new(size_t size);
+		static void operator delete(void* ptr, size_t size);
+
+		Coroutine get_return_object() {
+			return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { pError = std::current_exception(); }
+	};
+	typedef std::coroutine_handle<promise_type> Handle;
+private:
+	Handle handle_;
+public:
+	Coroutine() : handle_(nullptr) {}
+	explicit Coroutine(Handle handle) : handle_(handle) {}
+	Coroutine(Coroutine&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+	Coroutine& operator=(Coroutine&& other) noexcept;
+	Coroutine(const Coroutine&) = delete;
+	Coroutine& operator=(const Coroutine&) = delete;
+	~Coroutine();
+
+	static SizeClassPool* GetPool();
+
+	bool IsValid() { return handle_ != nullptr; }
+	bool IsDone() { return handle_ == nullptr || handle_.done(); }
+
+	//Runs until the next suspension, returns the amount of frames it asked to wait for
+	size_t Resume();
+};
+
+struct WaitFrames {
+	size_t frames;
+
+	WaitFrames(size_t count) : frames(count) {}
+
+	bool await_ready() noexcept { return frames == 0U; }
+	void await_suspend(Coroutine::Handle handle) noexcept { handle.promise().frameWait = frames; }
+	void await_resume() noexcept {}
+};
+
+//*******************************************************************
+//CoroutineTask
+//	Resumes its coroutine once per frame, and sleeps in the scene
+//	while the coroutine waits so it costs nothing until it is due.
+//*******************************************************************
+class CoroutineTask : public TaskBase {
+protected:
+	Coroutine routine_;
+public:
+	CoroutineTask(Scene* parent, Coroutine&& routine);
+	virtual ~CoroutineTask();
+
+	virtual void Update();
+	//A coroutine frame can't be rewound to an earlier point
+	virtual bool IsSnapshotSupported() { return false; }
+};
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include "../../pch.h"
+
+#include "Snapshot.hpp"
+
+//*******************************************************************
+//TimingWheel
+//	Hierarchical timer wheel keyed on frame numbers, 4 levels of 256 slots.
+//	Scheduling is O(1); each tick only touches the slot that is due,
+//	plus one cascade per level boundary.
+//*******************************************************************
+template<typename T>
+class TimingWheel {
+public:
+	static constexpr size_t LEVEL_BITS = 8U;
+	static constexpr size_t SLOT_COUNT = 1U << LEVEL_BITS;
+	static constexpr size_t LEVEL_COUNT = 4U;
+
+	struct Entry {
+		uint64_t frame;
+		T value;
+	};
+private:
+	std::vector<Entry> listSlot_[LEVEL_COUNT][SLOT_COUNT];
+	std::vector<Entry> listScratch_;
+	uint64_t frameCurrent_;		//Next frame to be processed
+	size_t count_;
+
+	void _Insert(const Entry& entry) {
+		//Entries already due go in the current slot
+		uint64_t frame = std::max(entry.frame, frameCurrent_);
+		uint64_t diff = frame ^ frameCurrent_;
+
+		size_t level = 0U;
+		while (level < LEVEL_COUNT - 1U && (diff >> (LEVEL_BITS * (level + 1U))) != 0U)
+			++level;
+		size_t slot = (frame >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1U);
+		listSlot_[level][slot].push_back(entry);
+	}
+	void _Cascade(size_t level) {
+		size_t slot = (frameCurrent_ >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1U);
+		listScratch_.swap(listSlot_[level][slot]);
+		for (Entry& iEntry : listScratch_)
+			_Insert(iEntry);
+		listScratch_.clear();
+	}
+public:
+	TimingWheel() {
+		frameCurrent_ = 0U;
+		count_ = 0U;
+	}
+
+	void Clear(uint64_t frame = 0U) {
+		for (size_t i = 0; i < LEVEL_COUNT; ++i) {
+			for (size_t j = 0; j < SLOT_COUNT; ++j)
+				listSlot_[i][j].clear();
+		}
+		frameCurrent_ = frame;
+		count_ = 0U;
+	}
+
+	void Schedule(uint64_t frame, const T& value) {
+		_Insert(Entry{ frame, value });
+		++count_;
+	}
+
+	//Fires every entry due up to and including frame, in frame order.
+	//	callback(uint64_t frame, T&) may schedule new entries.
+	template<typename F>
+	void Advance(uint64_t frame, F&& callback) {
+		while (frameCurrent_ <= frame) {
+			//Higher levels first, so their entries can trickle all the way down
+			for (size_t level = LEVEL_COUNT - 1U; level > 0U; --level) {
+				uint64_t mask = ((uint64_t)1U << (LEVEL_BITS * level)) - 1U;
+				if ((frameCurrent_ & mask) == 0U)
+					_Cascade(level);
+			}
+
+			std::vector<Entry>& listDue = listSlot_[0][frameCurrent_ & (SLOT_COUNT - 1U)];
+			if (listDue.size() > 0) {
+				listScratch_.swap(listDue);
+				count_ -= listScratch_.size();
+				++frameCurrent_;	//Entries scheduled from the callback land in later slots
+				for (Entry& iEntry : listScratch_)
+					callback(iEntry.frame, iEntry.value);
+				listScratch_.clear();
+			}
+			else ++frameCurrent_;
+		}
+	}
+
+	void Serialize(SnapshotWriter* writer) {
+		static_assert(std::is_trivially_copyable<Entry>::value, "T must be trivially copyable");
+		writer->Write(frameCurrent_);
+		writer->Write(count_);
+		for (size_t i = 0; i < LEVEL_COUNT; ++i) {
+			for (size_t j = 0; j < SLOT_COUNT; ++j)
+				writer->WriteArray(listSlot_[i][j]);
+		}
+	}
+	void Restore(SnapshotReader* reader) {
+		reader->Read(frameCurrent_);
+		reader->Read(count_);
+		for (size_t i = 0; i < LEVEL_COUNT; ++i) {
+			for (size_t j = 0; j < SLOT_COUNT; ++j)
+				reader->ReadArray(listSlot_[i][j]);
+		}
+	}
+
+	uint64_t GetCurrentFrame() { return frameCurrent_; }
+	size_t GetCount() { return count_; }
+};
\ No newline at end of file
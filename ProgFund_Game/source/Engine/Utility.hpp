@@ -5,6 +5,7 @@
 //*******************************************************************
 //Error utilities
 //*******************************************************************
+#ifndef __L_HEADLESS
 class ErrorUtility {
 public:
 	static std::string StringFromHResult(HRESULT hr, bool bDescription = true) {
@@ -16,6 +17,7 @@ public:
 		return err;
 	}
 };
+#endif
 class EngineError {
 public:
 	EngineError() {}
@@ -137,12 +139,17 @@ public:
 		va_list	vl;
 		va_start(vl, str);
 
-		//The size returned by _vsnprintf does NOT include null terminator
-		int size = _vsnprintf(nullptr, 0U, str, vl);
+		//The list can't be reused after a v*printf call outside of MSVC
+		va_list vlSize;
+		va_copy(vlSize, vl);
+
+		//The size returned by vsnprintf does NOT include null terminator
+		int size = vsnprintf(nullptr, 0U, str, vlSize);
+		va_end(vlSize);
 		std::string res;
 		if (size > 0) {
 			res.resize(size + 1);
-			_vsnprintf((char*)res.c_str(), res.size(), str, vl);
+			vsnprintf((char*)res.c_str(), res.size(), str, vl);
 			res.pop_back();	//Don't include the null terminator
 		}
 
@@ -159,9 +166,13 @@ public:
 	static const std::string& GetModuleDirectory() {
 		static std::string moduleDir;
 		if (moduleDir.size() == 0) {
+#ifndef __L_HEADLESS
 			char modulePath[_MAX_PATH];
 			ZeroMemory(modulePath, sizeof(modulePath));
 			GetModuleFileNameA(NULL, modulePath, _MAX_PATH - 1);
+#else
+			stdfs::path modulePath = stdfs::read_symlink("/proc/self/exe");
+#endif
 			moduleDir = stdfs::path(modulePath).parent_path().make_preferred().generic_string();
 			moduleDir = moduleDir + "/";
 		}
@@ -170,8 +181,12 @@ public:
 	static const std::string& GetWorkingDirectory() {
 		static std::string dir;
 		if (dir.size() == 0) {
+#ifndef __L_HEADLESS
 			char path[MAX_PATH];
 			GetCurrentDirectoryA(MAX_PATH, path);
+#else
+			stdfs::path path = stdfs::current_path();
+#endif
 			dir = stdfs::path(path).make_preferred().generic_string();
 			dir = dir + "/";
 		}
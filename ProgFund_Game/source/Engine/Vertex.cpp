@@ -28,6 +28,7 @@ const DWORD VertexTLX::VertexFormat = D3DFVF_XYZ | D3DFVF_TEX1 | D3DFVF_DIFFUSE;
 VertexBufferManager* VertexBufferManager::base_ = nullptr;
 VertexBufferManager::VertexBufferManager() {
 	bufferDynamicIndex_ = nullptr;
+	bufferQuadIndex_ = nullptr;
 }
 VertexBufferManager::~VertexBufferManager() {
 }
@@ -60,6 +61,7 @@ void VertexBufferManager::Initialize() {
 	}
 
 	CreateBuffers();
+	_CreateQuadIndexBuffer();
 }
 void VertexBufferManager::Release() {
 	WindowMain* window = WindowMain::GetBase();
@@ -71,6 +73,7 @@ void VertexBufferManager::Release() {
 	for (auto& iBuffer : listBufferDynamicVertex_)
 		ptr_delete(iBuffer);
 	ptr_delete(bufferDynamicIndex_);
+	ptr_delete(bufferQuadIndex_);
 }
 
 void VertexBufferManager::CreateBuffers() {
@@ -103,6 +106,35 @@ void VertexBufferManager::CreateBuffers() {
 	}
 }
 
+void VertexBufferManager::_CreateQuadIndexBuffer() {
+	IDirect3DDevice9* device = WindowMain::GetBase()->GetDevice();
+
+	std::vector<uint16_t> listIndex(DX_MAX_QUAD_COUNT * 6U);
+	for (size_t i = 0; i < DX_MAX_QUAD_COUNT; ++i) {
+		uint16_t vertex = (uint16_t)(i * 4U);
+		uint16_t* dst = &listIndex[i * 6U];
+		dst[0] = vertex;
+		dst[1] = vertex + 1U;
+		dst[2] = vertex + 2U;
+		dst[3] = vertex + 2U;
+		dst[4] = vertex + 1U;
+		dst[5] = vertex + 3U;
+	}
+
+	bufferQuadIndex_ = new DxIndexBuffer(device, D3DUSAGE_WRITEONLY);
+	DWORD fmt = D3DFMT_INDEX16;
+	HRESULT hr = bufferQuadIndex_->Create(listIndex.size(), sizeof(uint16_t), D3DPOOL_MANAGED, &fmt);
+	if (SUCCEEDED(hr)) {
+		BufferLockParameter lockParam = BufferLockParameter(0U);
+		lockParam.SetSource(listIndex, listIndex.size(), sizeof(uint16_t));
+		hr = bufferQuadIndex_->UpdateBuffer(&lockParam);
+	}
+	if (FAILED(hr)) {
+		throw EngineError(StringUtility::Format("Failed to create quad index buffer.\n\t%s",
+			ErrorUtility::StringFromHResult(hr).c_str()));
+	}
+}
+
 void VertexBufferManager::OnLostDevice() {
 	for (auto& iBuffer : listBufferDynamicVertex_)
 		ptr_delete(iBuffer);
@@ -112,6 +112,7 @@ private:
 };
 
 #define DX_MAX_BUFFER_SIZE 0x10000u
+#define DX_MAX_QUAD_COUNT (DX_MAX_BUFFER_SIZE / 4u)
 class VertexBufferManager : public DxResourceManagerBase {
 	static VertexBufferManager* base_;
 public:
@@ -134,9 +135,14 @@ public:
 	DxVertexBuffer* GetDynamicVertexBuffer(size_t index) { return listBufferDynamicVertex_[index]; }
 	DxVertexBuffer* GetDynamicVertexBufferTLX() { return GetDynamicVertexBuffer(0); }
 	DxIndexBuffer* GetDynamicIndexBuffer() { return bufferDynamicIndex_; }
+	//Triangle list of DX_MAX_QUAD_COUNT quads, each 4 vertices ordered TL, TR, BL, BR
+	DxIndexBuffer* GetQuadIndexBuffer() { return bufferQuadIndex_; }
 private:
 	std::vector<IDirect3DVertexDeclaration9*> listDeclaration_;
 
 	std::vector<DxVertexBuffer*> listBufferDynamicVertex_;
 	DxIndexBuffer* bufferDynamicIndex_;
+	DxIndexBuffer* bufferQuadIndex_;	//Managed, kept through device resets
+
+	void _CreateQuadIndexBuffer();
 };
\ No newline at end of file
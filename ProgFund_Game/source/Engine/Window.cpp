@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Window.hpp"
+#include "Profiler.hpp"
 
 //*******************************************************************
 //WindowMain
@@ -222,10 +223,12 @@ bool WindowMain::_TestDeviceCooperation() {
 }
 
 void WindowMain::BeginScene(D3DCOLOR clearColor) {
+	PROFILE_ZONE("WindowMain::BeginScene");
 	pDevice_->Clear(1, nullptr, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, clearColor, 1.0f, 0);
 	pDevice_->BeginScene();
 }
 void WindowMain::EndScene(bool bPresent) {
+	PROFILE_ZONE("WindowMain::EndScene");
 	pDevice_->EndScene();
 	if (bPresent) {
 		pDevice_->Present(nullptr, nullptr, nullptr, nullptr);
@@ -234,6 +237,13 @@ void WindowMain::EndScene(bool bPresent) {
 	}
 }
 
+UINT WindowMain::GetRefreshRate() {
+	D3DDISPLAYMODE mode;
+	if (FAILED(pDirect3D_->GetAdapterDisplayMode(D3DADAPTER_DEFAULT, &mode)))
+		return 0U;
+	return mode.RefreshRate;
+}
+
 void WindowMain::SetBlendMode(BlendMode mode) {
 	if (mode == previousBlendMode_) return;
 	if (previousBlendMode_ == (BlendMode)0xff) {
@@ -11,13 +11,6 @@ enum class WindowMode : uint8_t {
 	Windowed,
 	Fullscreen,
 };
-enum class BlendMode : uint8_t {
-	Alpha,
-	Add,
-	Subtract,
-	RevSubtract,
-	Invert,
-};
 enum class TextureSample : uint8_t {
 	LinearLinear,
 	LinearNearest,
@@ -86,6 +79,9 @@ public:
 	void AddDxResourceListener(DxResourceManagerBase* object);
 	void RemoveDxResourceListener(DxResourceManagerBase* object);
 
+	//Of the display the default adapter drives, 0 if it isn't known
+	UINT GetRefreshRate();
+
 	void SetFPS(float fps) { fps_ = fps; }
 	float GetFPS(float fps) { return fps_; }
 
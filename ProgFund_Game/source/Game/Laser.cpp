@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "Laser.hpp"
+
+//*******************************************************************
+//Laser
+//*******************************************************************
+Laser::Laser(size_t countNodeMax) {
+	countNodeMax_ = std::max(countNodeMax, (size_t)2U);
+
+	//The live nodes never wrap around into the leaf they started in
+	capacity_ = LEAF_SIZE * 2U;
+	while (capacity_ < countNodeMax_ + LEAF_SIZE * 2U)
+		capacity_ *= 2U;
+	countLeaf_ = capacity_ / LEAF_SIZE;
+
+	listAX_.Resize(capacity_, 0U);
+	listAY_.Resize(capacity_, 0U);
+	listBX_.Resize(capacity_, 0U);
+	listBY_.Resize(capacity_, 0U);
+	listBox_.resize(countLeaf_ * 2U);
+	listLeafMask_.resize(countLeaf_);
+	listLeafDirty_.resize(countLeaf_);
+	listDirty_.reserve(countLeaf_);
+
+	radius_ = 0.0f;
+	Clear();
+}
+Laser::~Laser() {
+}
+
+void Laser::Clear() {
+	first_ = 0U;
+	count_ = 0U;
+	std::fill(listBox_.begin(), listBox_.end(), Box{ INFINITY, INFINITY, -INFINITY, -INFINITY });
+	std::fill(listLeafMask_.begin(), listLeafMask_.end(), 0U);
+	std::fill(listLeafDirty_.begin(), listLeafDirty_.end(), 0U);
+	listDirty_.clear();
+}
+
+void Laser::_SetSegment(size_t slot, bool bValid) {
+	size_t leaf = slot / LEAF_SIZE;
+	uint8_t bit = (uint8_t)(1U << (slot % LEAF_SIZE));
+	if (bValid)
+		listLeafMask_[leaf] |= bit;
+	else
+		listLeafMask_[leaf] &= (uint8_t)~bit;
+
+	if (!listLeafDirty_[leaf]) {
+		listLeafDirty_[leaf] = 1U;
+		listDirty_.push_back((uint32_t)leaf);
+	}
+}
+
+void Laser::AddNode(float x, float y) {
+	if (count_ == countNodeMax_)
+		RemoveTail();
+
+	size_t mask = capacity_ - 1U;
+	size_t slot = (first_ + count_) & mask;
+	listAX_[slot] = x;
+	listAY_[slot] = y;
+	if (count_ > 0U) {
+		size_t slotPrev = (slot - 1U) & mask;
+		listBX_[slotPrev] = x;
+		listBY_[slotPrev] = y;
+		_SetSegment(slotPrev, true);
+	}
+	++count_;
+}
+void Laser::RemoveTail() {
+	if (count_ == 0U) return;
+	if (count_ >= 2U)
+		_SetSegment(first_ & (capacity_ - 1U), false);
+	++first_;
+	--count_;
+}
+void Laser::SetSegment(float x0, float y0, float x1, float y1) {
+	//Through RemoveTail, which only touches the leaves that held segments
+	while (count_ > 0U)
+		RemoveTail();
+	AddNode(x0, y0);
+	AddNode(x1, y1);
+}
+
+//Leaf boxes from the endpoints of their segments, then the path up to the root
+void Laser::_Refit() {
+	for (uint32_t leaf : listDirty_) {
+		listLeafDirty_[leaf] = 0U;
+
+		Box box{ INFINITY, INFINITY, -INFINITY, -INFINITY };
+		uint8_t mask = listLeafMask_[leaf];
+		for (size_t iLane = 0; iLane < LEAF_SIZE; ++iLane) {
+			if ((mask & (1U << iLane)) == 0U) continue;
+			size_t slot = leaf * LEAF_SIZE + iLane;
+			box.left = std::min(box.left, std::min(listAX_[slot], listBX_[slot]));
+			box.top = std::min(box.top, std::min(listAY_[slot], listBY_[slot]));
+			box.right = std::max(box.right, std::max(listAX_[slot], listBX_[slot]));
+			box.bottom = std::max(box.bottom, std::max(listAY_[slot], listBY_[slot]));
+		}
+
+		size_t node = countLeaf_ + leaf;
+		listBox_[node] = box;
+		for (node /= 2U; node > 0U; node /= 2U) {
+			const Box& left = listBox_[node * 2U];
+			const Box& right = listBox_[node * 2U + 1U];
+			listBox_[node] = Box{
+				std::min(left.left, right.left), std::min(left.top, right.top),
+				std::max(left.right, right.right), std::max(left.bottom, right.bottom),
+			};
+		}
+	}
+	listDirty_.clear();
+}
+
+Laser::Contact Laser::Test(float x, float y, float radiusHit, float radiusGraze, SimdLevel level) {
+	if (count_ < 2U) return Contact::None;
+	_Refit();
+
+	SimdLevel kernel = CpuFeature::Resolve(level);
+	float reachHit = radius_ + radiusHit;
+	float reachGraze = radius_ + radiusGraze;
+	float reachHitSq = reachHit * reachHit;
+	float reachGrazeSq = reachGraze * reachGraze;
+
+	//Once grazing, only boxes that could still hold a hit are worth descending into
+	float limitSq = std::max(reachHitSq, reachGrazeSq);
+	bool bGraze = false;
+
+	uint32_t stack[64];
+	size_t depth = 0U;
+	stack[depth++] = 1U;
+	while (depth > 0U) {
+		size_t node = stack[--depth];
+		const Box& box = listBox_[node];
+		float dx = std::max(std::max(box.left - x, x - box.right), 0.0f);
+		float dy = std::max(std::max(box.top - y, y - box.bottom), 0.0f);
+		if (!(dx * dx + dy * dy <= limitSq)) continue;
+
+		if (node < countLeaf_) {
+			stack[depth++] = (uint32_t)(node * 2U + 1U);
+			stack[depth++] = (uint32_t)(node * 2U);
+			continue;
+		}
+
+		size_t leaf = node - countLeaf_;
+		float distSq;
+		switch (kernel) {
+		case SimdLevel::AVX:
+		case SimdLevel::AVX2:
+			distSq = _TestLeafAVX(leaf, x, y);
+			break;
+		case SimdLevel::SSE2:
+			distSq = _TestLeafSSE2(leaf, x, y);
+			break;
+		default:
+			distSq = _TestLeafScalar(leaf, x, y);
+			break;
+		}
+
+		if (distSq <= reachHitSq)
+			return Contact::Hit;
+		if (distSq <= reachGrazeSq) {
+			bGraze = true;
+			limitSq = reachHitSq;
+		}
+	}
+	return bGraze ? Contact::Graze : Contact::None;
+}
+
+//Per segment, in this exact order in every kernel, with d = b - a:
+//	t = ((x - ax) * dx + (y - ay) * dy) / (dx * dx + dy * dy), or 0 for a zero-length segment
+//	t clamped to [0, 1], then distSq = ex * ex + ey * ey with e = (x, y) - (a + t * d)
+//	The leaf's result is the least distSq of its segments, infinity if it has none.
+float Laser::_TestLeafScalar(size_t leaf, float x, float y) const {
+	float distMin = INFINITY;
+	uint8_t mask = listLeafMask_[leaf];
+	for (size_t iLane = 0; iLane < LEAF_SIZE; ++iLane) {
+		if ((mask & (1U << iLane)) == 0U) continue;
+		size_t slot = leaf * LEAF_SIZE + iLane;
+		float ax = listAX_[slot];
+		float ay = listAY_[slot];
+		float dx = listBX_[slot] - ax;
+		float dy = listBY_[slot] - ay;
+		float lengthSq = dx * dx + dy * dy;
+
+		float t = (x - ax) * dx + (y - ay) * dy;
+		t = lengthSq > 0.0f ? t / lengthSq : 0.0f;
+		t = t > 0.0f ? t : 0.0f;
+		t = t < 1.0f ? t : 1.0f;
+
+		float ex = x - (ax + t * dx);
+		float ey = y - (ay + t * dy);
+		float distSq = ex * ex + ey * ey;
+		distMin = distSq < distMin ? distSq : distMin;
+	}
+	return distMin;
+}
+float Laser::_TestLeafSSE2(size_t leaf, float x, float y) const {
+	const __m128 px = _mm_set1_ps(x);
+	const __m128 py = _mm_set1_ps(y);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 inf = _mm_set1_ps(INFINITY);
+	const __m128i maskLeaf = _mm_set1_epi32(listLeafMask_[leaf]);
+
+	__m128 distMin = inf;
+	for (size_t iHalf = 0; iHalf < LEAF_SIZE; iHalf += 4U) {
+		size_t slot = leaf * LEAF_SIZE + iHalf;
+		__m128i bits = _mm_setr_epi32(1 << iHalf, 2 << iHalf, 4 << iHalf, 8 << iHalf);
+		__m128 valid = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(maskLeaf, bits), bits));
+
+		__m128 ax = _mm_load_ps(&listAX_[slot]);
+		__m128 ay = _mm_load_ps(&listAY_[slot]);
+		__m128 dx = _mm_sub_ps(_mm_load_ps(&listBX_[slot]), ax);
+		__m128 dy = _mm_sub_ps(_mm_load_ps(&listBY_[slot]), ay);
+		__m128 lengthSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+		__m128 t = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(px, ax), dx), _mm_mul_ps(_mm_sub_ps(py, ay), dy));
+		t = _mm_and_ps(_mm_div_ps(t, lengthSq), _mm_cmpgt_ps(lengthSq, zero));
+		t = _mm_min_ps(_mm_max_ps(t, zero), one);
+
+		__m128 ex = _mm_sub_ps(px, _mm_add_ps(ax, _mm_mul_ps(t, dx)));
+		__m128 ey = _mm_sub_ps(py, _mm_add_ps(ay, _mm_mul_ps(t, dy)));
+		__m128 distSq = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+		distSq = _mm_or_ps(_mm_and_ps(valid, distSq), _mm_andnot_ps(valid, inf));
+		distMin = _mm_min_ps(distSq, distMin);
+	}
+	distMin = _mm_min_ps(distMin, _mm_movehl_ps(distMin, distMin));
+	distMin = _mm_min_ss(distMin, _mm_shuffle_ps(distMin, distMin, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(distMin);
+}
+SIMD_TARGET_AVX float Laser::_TestLeafAVX(size_t leaf, float x, float y) const {
+	const __m256 px = _mm256_set1_ps(x);
+	const __m256 py = _mm256_set1_ps(y);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 inf = _mm256_set1_ps(INFINITY);
+
+	//No 256-bit integer compares before AVX2, so the lane mask is built in halves
+	const __m128i maskLeaf = _mm_set1_epi32(listLeafMask_[leaf]);
+	const __m128i bitsLo = _mm_setr_epi32(1, 2, 4, 8);
+	const __m128i bitsHi = _mm_setr_epi32(16, 32, 64, 128);
+	__m256 valid = _mm256_insertf128_ps(
+		_mm256_castps128_ps256(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(maskLeaf, bitsLo), bitsLo))),
+		_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(maskLeaf, bitsHi), bitsHi)), 1);
+
+	size_t slot = leaf * LEAF_SIZE;
+	__m256 ax = _mm256_load_ps(&listAX_[slot]);
+	__m256 ay = _mm256_load_ps(&listAY_[slot]);
+	__m256 dx = _mm256_sub_ps(_mm256_load_ps(&listBX_[slot]), ax);
+	__m256 dy = _mm256_sub_ps(_mm256_load_ps(&listBY_[slot]), ay);
+	__m256 lengthSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+	__m256 t = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(px, ax), dx), _mm256_mul_ps(_mm256_sub_ps(py, ay), dy));
+	t = _mm256_and_ps(_mm256_div_ps(t, lengthSq), _mm256_cmp_ps(lengthSq, zero, _CMP_GT_OQ));
+	t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+
+	__m256 ex = _mm256_sub_ps(px, _mm256_add_ps(ax, _mm256_mul_ps(t, dx)));
+	__m256 ey = _mm256_sub_ps(py, _mm256_add_ps(ay, _mm256_mul_ps(t, dy)));
+	__m256 distSq = _mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey));
+	distSq = _mm256_or_ps(_mm256_and_ps(valid, distSq), _mm256_andnot_ps(valid, inf));
+
+	__m128 distMin = _mm_min_ps(_mm256_castps256_ps128(distSq), _mm256_extractf128_ps(distSq, 1));
+	distMin = _mm_min_ps(distMin, _mm_movehl_ps(distMin, distMin));
+	distMin = _mm_min_ss(distMin, _mm_shuffle_ps(distMin, distMin, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(distMin);
+}
\ No newline at end of file
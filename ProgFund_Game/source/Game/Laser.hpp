@@ -0,0 +1,84 @@
+#pragma once
+#include "../../pch.h"
+
+#include "../Engine/MemoryPool.hpp"
+#include "../Engine/Simd.hpp"
+
+//*******************************************************************
+//Laser
+//	Collision shape of a laser: a chain of nodes swept by a radius, tested
+//	as one capsule per segment. Straight and loose lasers are a single
+//	segment set every frame; curvy lasers append a node at the head and
+//	drop the oldest past their length, as nodes never move once placed.
+//	Nodes live in a ring, and groups of LEAF_SIZE segments are the leaves
+//	of a bounding box tree. Changing the chain only refits the touched
+//	leaves and their parents, and a query descends to the leaves near the
+//	point, testing their segments 4/8 at a time. Every kernel performs the
+//	same float operations, so they agree on every contact.
+//*******************************************************************
+class Laser {
+public:
+	static constexpr size_t LEAF_SIZE = 8U;
+
+	enum class Contact : uint8_t {
+		None,
+		Graze,
+		Hit,
+	};
+private:
+	struct Box {
+		float left, top, right, bottom;
+	};
+
+	size_t capacity_;		//Ring size, a power of two
+	size_t countNodeMax_;
+	size_t first_;			//Sequence number of the oldest node, its ring slot is first_ & (capacity_ - 1)
+	size_t count_;
+	float radius_;
+
+	//Per ring slot: the node, and the next one towards the head as the segment's other end
+	AlignedArray<float> listAX_;
+	AlignedArray<float> listAY_;
+	AlignedArray<float> listBX_;
+	AlignedArray<float> listBY_;
+
+	//Implicit tree: 1 is the root, node n has children 2n and 2n + 1, leaves start at countLeaf_
+	size_t countLeaf_;
+	std::vector<Box> listBox_;
+	std::vector<uint8_t> listLeafMask_;		//Per leaf, the slots holding a segment
+	std::vector<uint8_t> listLeafDirty_;
+	std::vector<uint32_t> listDirty_;
+
+	void _SetSegment(size_t slot, bool bValid);
+	void _Refit();
+
+	float _TestLeafScalar(size_t leaf, float x, float y) const;
+	float _TestLeafSSE2(size_t leaf, float x, float y) const;
+	SIMD_TARGET_AVX float _TestLeafAVX(size_t leaf, float x, float y) const;
+public:
+	//countNodeMax is the length of a curvy laser in nodes; straight and loose lasers need 2
+	Laser(size_t countNodeMax);
+	~Laser();
+
+	//Collision width, the capsule radius is half of it
+	void SetWidth(float width) { radius_ = width * 0.5f; }
+	float GetWidth() { return radius_ * 2.0f; }
+
+	void Clear();
+	//Appends a head node, dropping the oldest one once countNodeMax is reached
+	void AddNode(float x, float y);
+	//Drops the oldest node, as when a curvy laser's tail runs past its last emitted node
+	void RemoveTail();
+	//Replaces the chain with one segment, for straight and loose lasers
+	void SetSegment(float x0, float y0, float x1, float y1);
+
+	size_t GetNodeCount() { return count_; }
+	size_t GetNodeCountMax() { return countNodeMax_; }
+
+	//Nearest capsule against circles of radiusHit and radiusGraze around the point; the hit takes precedence.
+	//	The level is clamped to what the CPU supports.
+	Contact Test(float x, float y, float radiusHit, float radiusGraze, SimdLevel level);
+	Contact Test(float x, float y, float radiusHit, float radiusGraze) {
+		return Test(x, y, radiusHit, radiusGraze, CpuFeature::GetSimdLevel());
+	}
+};
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "ShotBatch.hpp"
+
+//*******************************************************************
+//ShotBatchBase
+//*******************************************************************
+ShotBatchBase::ShotBatchBase() {
+	SetViewRect(0.0f, 0.0f, 640.0f, 480.0f);
+}
+
+void ShotBatchBase::SetViewRect(float left, float top, float right, float bottom) {
+	viewLeft_ = left;
+	viewTop_ = top;
+	viewRight_ = right;
+	viewBottom_ = bottom;
+}
+
+size_t ShotBatchBase::_SortShots(ShotManager* manager, ShotDataTable* table, size_t countGraphic,
+	uint16_t texture, size_t index, size_t* listOffset)
+{
+	size_t count = manager->GetCount();
+	const float* listX = manager->GetX();
+	const float* listY = manager->GetY();
+	const uint16_t* listGraphic = manager->GetGraphic();
+	const uint16_t* listFlags = manager->GetFlags();
+	const ShotGraphic* listShotData = table->GetShotData();
+	countGraphic = std::min(countGraphic, table->GetShotCount());
+
+	if (listKey_.size() < count)
+		listKey_.resize(count);
+
+	//Count per blend
+	size_t listCount[BLEND_COUNT] = {};
+	for (size_t i = 0; i < count; ++i) {
+		listKey_[i] = NO_KEY;
+		if (listFlags[i] & ShotManager::FLAG_DELETED) continue;
+		if (listGraphic[i] >= countGraphic) continue;
+
+		const ShotGraphic* graphic = &listShotData[listGraphic[i]];
+		if (!graphic->IsDefined()) continue;
+
+		//Covers the half diagonal at any rotation
+		float extent = (graphic->width + graphic->height) * 0.5f;
+		if (listX[i] + extent < viewLeft_ || listX[i] - extent > viewRight_
+			|| listY[i] + extent < viewTop_ || listY[i] - extent > viewBottom_) continue;
+
+		uint8_t key = (uint8_t)graphic->blend;
+		listKey_[i] = key;
+		++listCount[key];
+	}
+
+	for (size_t iKey = 0; iKey < BLEND_COUNT; ++iKey) {
+		listOffset[iKey] = index;
+		if (listCount[iKey] == 0U) continue;
+		listBatch_.push_back(Batch{ texture, (BlendMode)iKey, index, listCount[iKey] });
+		index += listCount[iKey];
+	}
+	return index;
+}
+
+void ShotBatchBase::_GetRotation(const ShotGraphic* graphic, float dirX, float dirY, uint64_t frame, float* c, float* s) {
+	if (graphic->flags & ShotGraphic::FLAG_SPIN) {
+		//Wrapped in double, a float angle loses precision as the frame count grows
+		float angle = (float)fmod((double)graphic->spin * (double)frame, GM_PI_X2);
+		*c = cosf(angle);
+		*s = sinf(angle);
+	}
+	else if (graphic->flags & ShotGraphic::FLAG_FIXED_ANGLE) {
+		*c = 1.0f;
+		*s = 0.0f;
+	}
+	else {
+		*c = -dirY;
+		*s = dirX;
+	}
+}
+
+//*******************************************************************
+//ShotBatchList
+//*******************************************************************
+ShotBatchList::ShotBatchList() {
+}
+ShotBatchList::~ShotBatchList() {
+}
+
+void ShotBatchList::Clear() {
+	listVertex_.clear();
+	listBatch_.clear();
+}
+
+void ShotBatchList::SourceBuffer::Reserve(size_t count) {
+	if (x.size() >= count) return;
+	for (std::vector<float>* iList : { &x, &y, &cos, &sin, &halfWidth, &halfHeight, &u0, &v0, &u1, &v1 })
+		iList->resize(count);
+	color.resize(count, 0xffffffffU);
+}
+QuadSource ShotBatchList::SourceBuffer::GetSource() {
+	return QuadSource{ x.data(), y.data(), cos.data(), sin.data(), halfWidth.data(), halfHeight.data(),
+		u0.data(), v0.data(), u1.data(), v1.data(), color.data() };
+}
+
+void ShotBatchList::AddShots(ShotManager* manager, ShotDataTable* table, uint16_t texture, uint64_t frame) {
+	size_t indexFirst = GetQuadCount();
+	size_t listOffset[BLEND_COUNT];
+	size_t countQuad = _SortShots(manager, table, table->GetShotCount(), texture, indexFirst, listOffset);
+	if (countQuad == indexFirst) return;
+	listVertex_.resize(countQuad * 4U);
+	source_.Reserve(countQuad - indexFirst);
+
+	size_t count = manager->GetCount();
+	const float* listX = manager->GetX();
+	const float* listY = manager->GetY();
+	const float* listDirX = manager->GetDirX();
+	const float* listDirY = manager->GetDirY();
+	const uint16_t* listGraphic = manager->GetGraphic();
+	const ShotGraphic* listShotData = table->GetShotData();
+
+	//Colors stay white from Reserve
+	for (size_t i = 0; i < count; ++i) {
+		uint8_t key = listKey_[i];
+		if (key == NO_KEY) continue;
+
+		const ShotGraphic* graphic = &listShotData[listGraphic[i]];
+		size_t index = listOffset[key]++ - indexFirst;
+		_GetRotation(graphic, listDirX[i], listDirY[i], frame, &source_.cos[index], &source_.sin[index]);
+		//Bias as in Sprite2D
+		source_.x[index] = listX[i] - 0.5f;
+		source_.y[index] = listY[i] - 0.5f;
+		source_.halfWidth[index] = graphic->width * 0.5f;
+		source_.halfHeight[index] = graphic->height * 0.5f;
+		source_.u0[index] = graphic->u0;
+		source_.v0[index] = graphic->v0;
+		source_.u1[index] = graphic->u1;
+		source_.v1[index] = graphic->v1;
+	}
+
+	QuadKernel::Build(source_.GetSource(), countQuad - indexFirst, &listVertex_[indexFirst * 4U]);
+}
+
+//*******************************************************************
+//ShotInstanceList
+//*******************************************************************
+ShotInstanceList::ShotInstanceList() {
+}
+ShotInstanceList::~ShotInstanceList() {
+}
+
+void ShotInstanceList::Clear() {
+	listInstance_.clear();
+	listBatch_.clear();
+}
+
+void ShotInstanceList::AddShots(ShotManager* manager, ShotDataTable* table, uint16_t texture, uint64_t frame) {
+	size_t listOffset[BLEND_COUNT];
+	size_t countInstance = _SortShots(manager, table, MAX_GRAPHIC, texture, GetInstanceCount(), listOffset);
+	listInstance_.resize(countInstance);
+
+	size_t count = manager->GetCount();
+	const float* listX = manager->GetX();
+	const float* listY = manager->GetY();
+	const float* listDirX = manager->GetDirX();
+	const float* listDirY = manager->GetDirY();
+	const uint16_t* listGraphic = manager->GetGraphic();
+	const ShotGraphic* listShotData = table->GetShotData();
+
+	ShotInstance* listInstance = listInstance_.data();
+	for (size_t i = 0; i < count; ++i) {
+		uint8_t key = listKey_[i];
+		if (key == NO_KEY) continue;
+
+		float c, s;
+		_GetRotation(&listShotData[listGraphic[i]], listDirX[i], listDirY[i], frame, &c, &s);
+
+		ShotInstance* dst = &listInstance[listOffset[key]++];
+		dst->x = listX[i];
+		dst->y = listY[i];
+		dst->rotation[0] = (int16_t)(c * 32767.0f);
+		dst->rotation[1] = (int16_t)(s * 32767.0f);
+		dst->graphic = (int16_t)listGraphic[i];
+		dst->scale = 0x100;
+		dst->color = 0xffffffffU;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+#include "../../pch.h"
+
+#include "../Engine/QuadKernel.hpp"
+
+#include "ShotManager.hpp"
+#include "ShotData.hpp"
+
+//Per-instance stream of shot_instanced.fx: 20 bytes, against 96 for an expanded quad
+struct ShotInstance {
+	float x, y;
+	int16_t rotation[2];	//cos, sin, scaled by 32767
+	int16_t graphic;		//Index into the shader's UV rect table
+	int16_t scale;			//8.8 fixed point
+	uint32_t color;
+};
+
+//*******************************************************************
+//ShotBatchBase
+//	Sorting shared by the quad and instance lists. A pass over the shots
+//	counts the visible ones per blend, then each is written straight to its
+//	place, giving one batch per (texture, blend) with shots in storage order.
+//*******************************************************************
+class ShotBatchBase {
+public:
+	static constexpr size_t BLEND_COUNT = (size_t)BlendMode::Invert + 1U;
+
+	struct Batch {
+		uint16_t texture;	//Caller-defined texture index
+		BlendMode blend;
+		size_t index;		//First quad or instance
+		size_t count;
+	};
+protected:
+	static constexpr uint8_t NO_KEY = 0xffU;
+
+	std::vector<Batch> listBatch_;
+	std::vector<uint8_t> listKey_;		//Per shot scratch: blend, or NO_KEY if not drawn
+
+	float viewLeft_;
+	float viewTop_;
+	float viewRight_;
+	float viewBottom_;
+
+	//Sets listKey_ and appends the batches from index on; listOffset receives each blend's first slot.
+	//	Graphics from countGraphic on are skipped. Returns the index past the new batches.
+	size_t _SortShots(ShotManager* manager, ShotDataTable* table, size_t countGraphic,
+		uint16_t texture, size_t index, size_t* listOffset);
+	//Graphics point up in the atlas, so facing the direction of motion is a rotation by angle + 90 degrees
+	static void _GetRotation(const ShotGraphic* graphic, float dirX, float dirY, uint64_t frame, float* c, float* s);
+public:
+	ShotBatchBase();
+
+	//Shots entirely outside the rect are skipped
+	void SetViewRect(float left, float top, float right, float bottom);
+
+	const std::vector<Batch>& GetBatches() const { return listBatch_; }
+};
+
+//*******************************************************************
+//ShotBatchList
+//	One frame of shot quads, built on the CPU. Vertices are ordered
+//	TL, TR, BL, BR to match VertexBufferManager's quad index buffer.
+//	Shots are gathered into QuadKernel's arrays in batch order, then
+//	expanded by it in one call.
+//*******************************************************************
+class ShotBatchList : public ShotBatchBase {
+private:
+	struct SourceBuffer {
+		std::vector<float> x, y, cos, sin, halfWidth, halfHeight, u0, v0, u1, v1;
+		std::vector<uint32_t> color;
+
+		void Reserve(size_t count);
+		QuadSource GetSource();
+	};
+
+	std::vector<QuadVertex> listVertex_;
+	SourceBuffer source_;
+public:
+	ShotBatchList();
+	~ShotBatchList();
+
+	//Keeps the capacity, so lists rebuilt every frame stop allocating once grown
+	void Clear();
+
+	//Appends the manager's shots as one batch per blend; spinning graphics are rotated for the frame
+	void AddShots(ShotManager* manager, ShotDataTable* table, uint16_t texture, uint64_t frame);
+
+	const QuadVertex* GetVertices() const { return listVertex_.data(); }
+	size_t GetQuadCount() const { return listVertex_.size() / 4U; }
+};
+
+//*******************************************************************
+//ShotInstanceList
+//	One frame of shots as instances, for the instanced path: the quad is
+//	expanded by the vertex shader from the instance and the UV rect table.
+//*******************************************************************
+class ShotInstanceList : public ShotBatchBase {
+public:
+	//Size of the UV rect table in shot_instanced.fx; higher graphic IDs are skipped
+	static constexpr size_t MAX_GRAPHIC = 250U;
+private:
+	std::vector<ShotInstance> listInstance_;
+public:
+	ShotInstanceList();
+	~ShotInstanceList();
+
+	void Clear();
+
+	void AddShots(ShotManager* manager, ShotDataTable* table, uint16_t texture, uint64_t frame);
+
+	const ShotInstance* GetInstances() const { return listInstance_.data(); }
+	size_t GetInstanceCount() const { return listInstance_.size(); }
+};
\ No newline at end of file
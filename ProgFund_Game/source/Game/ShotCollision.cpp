@@ -0,0 +1,393 @@
+#include "pch.h"
+#include "ShotCollision.hpp"
+#include "../Engine/Profiler.hpp"
+
+//Entry of the per-graphic radius table for a shot: the deleted flag shifted above any graphic
+//	makes the clamp send deleted shots to the NaN entry past the last graphic as well
+static inline size_t _GetRadiusIndex(uint16_t graphic, uint16_t flags, size_t countGraphic) {
+	uint32_t index = graphic | ((uint32_t)(flags & ShotManager::FLAG_DELETED) << 16);
+	return std::min<size_t>(index, countGraphic);
+}
+
+//Lanes of the block at blockBegin that fall inside [begin, end)
+static inline int _GetRangeMask(size_t blockBegin, size_t countLane, size_t begin, size_t end) {
+	size_t laneBegin = begin > blockBegin ? begin - blockBegin : 0U;
+	size_t laneEnd = std::min(end - blockBegin, countLane);
+	return ((1 << laneEnd) - 1) & ~((1 << laneBegin) - 1);
+}
+
+//*******************************************************************
+//ShotGrid
+//*******************************************************************
+ShotGrid::ShotGrid() {
+	radiusMax_ = 0.0f;
+	count_ = 0U;
+	capacity_ = 0U;
+	countHit_ = 0U;
+	countGraze_ = 0U;
+	kernel_ = CpuFeature::GetSimdLevel();
+	SetGrid(-64.0f, -64.0f, SCREEN_WIDTH + 64.0f, SCREEN_HEIGHT + 64.0f, 32.0f);
+}
+ShotGrid::~ShotGrid() {
+}
+
+void ShotGrid::SetGrid(float left, float top, float right, float bottom, float cellSize) {
+	left_ = left;
+	top_ = top;
+	invCellSize_ = 1.0f / cellSize;
+	countColumn_ = std::max((size_t)ceilf((right - left) * invCellSize_), (size_t)1U);
+	countRow_ = std::max((size_t)ceilf((bottom - top) * invCellSize_), (size_t)1U);
+
+	listCellStart_.assign(countColumn_ * countRow_ + 1U, 0U);
+	count_ = 0U;
+	countHit_ = 0U;
+	countGraze_ = 0U;
+}
+
+void ShotGrid::_Grow(size_t capacity) {
+	capacity = (capacity + LANE_COUNT - 1U) & ~(LANE_COUNT - 1U);
+	//QueryAll grows between Build and Query too, the built grid has to survive it
+	listEntry_.Resize(capacity, count_);
+	listHit_.Resize(capacity, 0U);
+	listGraze_.Resize(capacity, 0U);
+	capacity_ = capacity;
+}
+
+//Clamped to the border cells; NaN goes to the first
+size_t ShotGrid::_GetColumn(float x) const {
+	float column = (x - left_) * invCellSize_;
+	if (!(column >= 0.0f)) return 0U;
+	if (column >= (float)countColumn_) return countColumn_ - 1U;
+	return (size_t)column;
+}
+size_t ShotGrid::_GetRow(float y) const {
+	float row = (y - top_) * invCellSize_;
+	if (!(row >= 0.0f)) return 0U;
+	if (row >= (float)countRow_) return countRow_ - 1U;
+	return (size_t)row;
+}
+
+void ShotGrid::Build(ShotManager* manager, ShotDataTable* table) {
+	PROFILE_ZONE("ShotGrid::Build");
+	size_t countShot = manager->GetCount();
+	const float* listX = manager->GetX();
+	const float* listY = manager->GetY();
+	const uint16_t* listGraphic = manager->GetGraphic();
+	const uint16_t* listFlags = manager->GetFlags();
+	const ShotGraphic* listShotData = table->GetShotData();
+	size_t countGraphic = table->GetShotCount();
+
+	if (listShotCell_.size() < countShot)
+		listShotCell_.resize(countShot);
+
+	//Count per cell
+	size_t countCell = countColumn_ * countRow_;
+	uint32_t* listStart = listCellStart_.data();
+	memset(listStart, 0, (countCell + 1U) * sizeof(uint32_t));
+
+	float radiusMax = 0.0f;
+	size_t count = 0U;
+	for (size_t i = 0; i < countShot; ++i) {
+		listShotCell_[i] = NO_CELL;
+		if (listFlags[i] & ShotManager::FLAG_DELETED) continue;
+		if (listGraphic[i] >= countGraphic) continue;
+
+		const ShotGraphic* graphic = &listShotData[listGraphic[i]];
+		if (!graphic->IsDefined()) continue;
+		radiusMax = std::max(radiusMax, graphic->radius);
+
+		uint32_t cell = (uint32_t)(_GetRow(listY[i]) * countColumn_ + _GetColumn(listX[i]));
+		listShotCell_[i] = cell;
+		++listStart[cell];
+		++count;
+	}
+
+	//Running totals give each cell's end; scattering backwards moves them to the starts
+	//	and keeps shots in storage order within a cell
+	for (size_t iCell = 1; iCell < countCell; ++iCell)
+		listStart[iCell] += listStart[iCell - 1U];
+	listStart[countCell] = (uint32_t)count;
+
+	if (count > capacity_)
+		_Grow(std::max(count, std::max(capacity_ * 2U, MIN_CAPACITY)));
+	count_ = count;
+	radiusMax_ = radiusMax;
+
+	Entry* listEntry = listEntry_.GetData();
+	for (size_t i = countShot; i-- > 0U;) {
+		uint32_t cell = listShotCell_[i];
+		if (cell == NO_CELL) continue;
+
+		listEntry[--listStart[cell]] = Entry{ listX[i], listY[i], listShotData[listGraphic[i]].radius, (uint32_t)i };
+	}
+}
+
+void ShotGrid::Query(float x, float y, float radiusHit, float radiusGraze) {
+	countHit_ = 0U;
+	countGraze_ = 0U;
+	if (count_ == 0U) return;
+
+	float reach = std::max(radiusHit, radiusGraze) + radiusMax_;
+	size_t column0 = _GetColumn(x - reach);
+	size_t column1 = _GetColumn(x + reach);
+	size_t row0 = _GetRow(y - reach);
+	size_t row1 = _GetRow(y + reach);
+
+	for (size_t iRow = row0; iRow <= row1; ++iRow) {
+		size_t cell = iRow * countColumn_;
+		size_t begin = listCellStart_[cell + column0];
+		size_t end = listCellStart_[cell + column1 + 1U];
+		if (begin >= end) continue;
+
+		switch (kernel_) {
+		case SimdLevel::AVX:
+		case SimdLevel::AVX2:
+			_TestAVX(begin, end, x, y, radiusHit, radiusGraze);
+			break;
+		case SimdLevel::SSE2:
+			_TestSSE2(begin, end, x, y, radiusHit, radiusGraze);
+			break;
+		default:
+			_TestScalar(begin, end, x, y, radiusHit, radiusGraze);
+			break;
+		}
+	}
+}
+
+void ShotGrid::QueryAll(ShotManager* manager, ShotDataTable* table, float x, float y, float radiusHit, float radiusGraze) {
+	PROFILE_ZONE("ShotGrid::QueryAll");
+	countHit_ = 0U;
+	countGraze_ = 0U;
+	size_t countShot = manager->GetCount();
+	if (countShot > capacity_)
+		_Grow(std::max(countShot, std::max(capacity_ * 2U, MIN_CAPACITY)));
+
+	//NaN for undefined graphics and one past the last, which deleted and out of range shots
+	//	are clamped to: every compare against it fails, so they neither hit nor graze
+	const ShotGraphic* listShotData = table->GetShotData();
+	size_t countGraphic = table->GetShotCount();
+	listRadius_.resize(countGraphic + 1U);
+	for (size_t i = 0; i < countGraphic; ++i)
+		listRadius_[i] = listShotData[i].IsDefined() ? listShotData[i].radius : std::numeric_limits<float>::quiet_NaN();
+	listRadius_[countGraphic] = std::numeric_limits<float>::quiet_NaN();
+
+	switch (kernel_) {
+	case SimdLevel::AVX2:
+		_TestAllAVX2(manager, x, y, radiusHit, radiusGraze);
+		break;
+	case SimdLevel::AVX:
+	case SimdLevel::SSE2:
+		_TestAllSSE2(manager, x, y, radiusHit, radiusGraze);
+		break;
+	default:
+		_TestAllScalar(manager, 0U, x, y, radiusHit, radiusGraze);
+		break;
+	}
+}
+
+//Per shot, in this exact order in every kernel:
+//	d2 = dx * dx + dy * dy, with dx = shot x - x and dy = shot y - y
+//	hit if d2 <= (radius + radiusHit)^2, else graze if d2 <= (radius + radiusGraze)^2
+void ShotGrid::_TestScalar(size_t begin, size_t end, float x, float y, float radiusHit, float radiusGraze) {
+	const Entry* listEntry = listEntry_.GetData();
+	for (size_t i = begin; i < end; ++i) {
+		const Entry* entry = &listEntry[i];
+		float dx = entry->x - x;
+		float dy = entry->y - y;
+		float distSq = dx * dx + dy * dy;
+		float reachHit = entry->radius + radiusHit;
+		float reachGraze = entry->radius + radiusGraze;
+		if (distSq <= reachHit * reachHit)
+			listHit_[countHit_++] = entry->index;
+		else if (distSq <= reachGraze * reachGraze)
+			listGraze_[countGraze_++] = entry->index;
+	}
+}
+void ShotGrid::_TestSSE2(size_t begin, size_t end, float x, float y, float radiusHit, float radiusGraze) {
+	const Entry* listEntry = listEntry_.GetData();
+
+	const __m128 cx = _mm_set1_ps(x);
+	const __m128 cy = _mm_set1_ps(y);
+	const __m128 rHit = _mm_set1_ps(radiusHit);
+	const __m128 rGraze = _mm_set1_ps(radiusGraze);
+
+	for (size_t i = begin & ~(size_t)3U; i < end; i += 4U) {
+		const float* block = &listEntry[i].x;
+		__m128 px = _mm_load_ps(block + 0);
+		__m128 py = _mm_load_ps(block + 4);
+		__m128 radius = _mm_load_ps(block + 8);
+		__m128 index = _mm_load_ps(block + 12);
+		_MM_TRANSPOSE4_PS(px, py, radius, index);
+
+		__m128 dx = _mm_sub_ps(px, cx);
+		__m128 dy = _mm_sub_ps(py, cy);
+		__m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 reachHit = _mm_add_ps(radius, rHit);
+		__m128 reachGraze = _mm_add_ps(radius, rGraze);
+
+		int maskRange = _GetRangeMask(i, 4U, begin, end);
+		int maskHit = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_mul_ps(reachHit, reachHit))) & maskRange;
+		int maskGraze = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_mul_ps(reachGraze, reachGraze))) & maskRange & ~maskHit;
+		if ((maskHit | maskGraze) == 0) continue;
+
+		for (size_t iLane = 0; iLane < 4U; ++iLane) {
+			if (maskHit & (1 << iLane))
+				listHit_[countHit_++] = listEntry[i + iLane].index;
+			else if (maskGraze & (1 << iLane))
+				listGraze_[countGraze_++] = listEntry[i + iLane].index;
+		}
+	}
+}
+SIMD_TARGET_AVX void ShotGrid::_TestAVX(size_t begin, size_t end, float x, float y, float radiusHit, float radiusGraze) {
+	const Entry* listEntry = listEntry_.GetData();
+
+	const __m256 cx = _mm256_set1_ps(x);
+	const __m256 cy = _mm256_set1_ps(y);
+	const __m256 rHit = _mm256_set1_ps(radiusHit);
+	const __m256 rGraze = _mm256_set1_ps(radiusGraze);
+
+	for (size_t i = begin & ~(size_t)7U; i < end; i += 8U) {
+		//Entries n and n + 4 share a register, so the in-lane transpose leaves lanes in order
+		const float* block = &listEntry[i].x;
+		__m256 row[4];
+		for (size_t iRow = 0; iRow < 4U; ++iRow) {
+			row[iRow] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(block + iRow * 4U)),
+				_mm_load_ps(block + (iRow + 4U) * 4U), 1);
+		}
+		__m256 xyLo = _mm256_unpacklo_ps(row[0], row[1]);
+		__m256 xyHi = _mm256_unpacklo_ps(row[2], row[3]);
+		__m256 rLo = _mm256_unpackhi_ps(row[0], row[1]);
+		__m256 rHi = _mm256_unpackhi_ps(row[2], row[3]);
+		__m256 px = _mm256_shuffle_ps(xyLo, xyHi, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 py = _mm256_shuffle_ps(xyLo, xyHi, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 radius = _mm256_shuffle_ps(rLo, rHi, _MM_SHUFFLE(1, 0, 1, 0));
+
+		__m256 dx = _mm256_sub_ps(px, cx);
+		__m256 dy = _mm256_sub_ps(py, cy);
+		__m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256 reachHit = _mm256_add_ps(radius, rHit);
+		__m256 reachGraze = _mm256_add_ps(radius, rGraze);
+
+		int maskRange = _GetRangeMask(i, 8U, begin, end);
+		int maskHit = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(reachHit, reachHit), _CMP_LE_OQ)) & maskRange;
+		int maskGraze = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(reachGraze, reachGraze), _CMP_LE_OQ))
+			& maskRange & ~maskHit;
+		if ((maskHit | maskGraze) == 0) continue;
+
+		for (size_t iLane = 0; iLane < 8U; ++iLane) {
+			if (maskHit & (1 << iLane))
+				listHit_[countHit_++] = listEntry[i + iLane].index;
+			else if (maskGraze & (1 << iLane))
+				listGraze_[countGraze_++] = listEntry[i + iLane].index;
+		}
+	}
+}
+
+//Every shot from begin on, in the same order of operations as the grid kernels
+void ShotGrid::_TestAllScalar(ShotManager* manager, size_t begin, float x, float y, float radiusHit, float radiusGraze) {
+	size_t count = manager->GetCount();
+	const float* listX = manager->GetX();
+	const float* listY = manager->GetY();
+	const uint16_t* listGraphic = manager->GetGraphic();
+	const uint16_t* listFlags = manager->GetFlags();
+	const float* listRadius = listRadius_.data();
+	size_t countGraphic = listRadius_.size() - 1U;
+
+	for (size_t i = begin; i < count; ++i) {
+		float radius = listRadius[_GetRadiusIndex(listGraphic[i], listFlags[i], countGraphic)];
+		float dx = listX[i] - x;
+		float dy = listY[i] - y;
+		float distSq = dx * dx + dy * dy;
+		float reachHit = radius + radiusHit;
+		float reachGraze = radius + radiusGraze;
+		if (distSq <= reachHit * reachHit)
+			listHit_[countHit_++] = (uint32_t)i;
+		else if (distSq <= reachGraze * reachGraze)
+			listGraze_[countGraze_++] = (uint32_t)i;
+	}
+}
+void ShotGrid::_TestAllSSE2(ShotManager* manager, float x, float y, float radiusHit, float radiusGraze) {
+	size_t count = manager->GetCount();
+	const float* listX = manager->GetX();
+	const float* listY = manager->GetY();
+	const uint16_t* listGraphic = manager->GetGraphic();
+	const uint16_t* listFlags = manager->GetFlags();
+	const float* listRadius = listRadius_.data();
+	size_t countGraphic = listRadius_.size() - 1U;
+
+	const __m128 cx = _mm_set1_ps(x);
+	const __m128 cy = _mm_set1_ps(y);
+	const __m128 rHit = _mm_set1_ps(radiusHit);
+	const __m128 rGraze = _mm_set1_ps(radiusGraze);
+
+	size_t i = 0;
+	for (; i + 4U <= count; i += 4U) {
+		//No gather before AVX2
+		__m128 radius = _mm_setr_ps(
+			listRadius[_GetRadiusIndex(listGraphic[i + 0U], listFlags[i + 0U], countGraphic)],
+			listRadius[_GetRadiusIndex(listGraphic[i + 1U], listFlags[i + 1U], countGraphic)],
+			listRadius[_GetRadiusIndex(listGraphic[i + 2U], listFlags[i + 2U], countGraphic)],
+			listRadius[_GetRadiusIndex(listGraphic[i + 3U], listFlags[i + 3U], countGraphic)]);
+
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(listX + i), cx);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(listY + i), cy);
+		__m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 reachHit = _mm_add_ps(radius, rHit);
+		__m128 reachGraze = _mm_add_ps(radius, rGraze);
+
+		int maskHit = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_mul_ps(reachHit, reachHit)));
+		int maskGraze = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_mul_ps(reachGraze, reachGraze))) & ~maskHit;
+		if ((maskHit | maskGraze) == 0) continue;
+
+		for (size_t iLane = 0; iLane < 4U; ++iLane) {
+			if (maskHit & (1 << iLane))
+				listHit_[countHit_++] = (uint32_t)(i + iLane);
+			else if (maskGraze & (1 << iLane))
+				listGraze_[countGraze_++] = (uint32_t)(i + iLane);
+		}
+	}
+	_TestAllScalar(manager, i, x, y, radiusHit, radiusGraze);
+}
+SIMD_TARGET_AVX2 void ShotGrid::_TestAllAVX2(ShotManager* manager, float x, float y, float radiusHit, float radiusGraze) {
+	size_t count = manager->GetCount();
+	const float* listX = manager->GetX();
+	const float* listY = manager->GetY();
+	const uint16_t* listGraphic = manager->GetGraphic();
+	const uint16_t* listFlags = manager->GetFlags();
+	const float* listRadius = listRadius_.data();
+
+	const __m256 cx = _mm256_set1_ps(x);
+	const __m256 cy = _mm256_set1_ps(y);
+	const __m256 rHit = _mm256_set1_ps(radiusHit);
+	const __m256 rGraze = _mm256_set1_ps(radiusGraze);
+	const __m256i flagDeleted = _mm256_set1_epi32(ShotManager::FLAG_DELETED);
+	const __m256i indexLast = _mm256_set1_epi32((int)(listRadius_.size() - 1U));
+
+	size_t i = 0;
+	for (; i + 8U <= count; i += 8U) {
+		__m256i graphic = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(listGraphic + i)));
+		__m256i flags = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(listFlags + i)));
+		__m256i index = _mm256_or_si256(graphic, _mm256_slli_epi32(_mm256_and_si256(flags, flagDeleted), 16));
+		__m256 radius = _mm256_i32gather_ps(listRadius, _mm256_min_epu32(index, indexLast), 4);
+
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(listX + i), cx);
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(listY + i), cy);
+		__m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256 reachHit = _mm256_add_ps(radius, rHit);
+		__m256 reachGraze = _mm256_add_ps(radius, rGraze);
+
+		int maskHit = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(reachHit, reachHit), _CMP_LE_OQ));
+		int maskGraze = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(reachGraze, reachGraze), _CMP_LE_OQ)) & ~maskHit;
+		if ((maskHit | maskGraze) == 0) continue;
+
+		for (size_t iLane = 0; iLane < 8U; ++iLane) {
+			if (maskHit & (1 << iLane))
+				listHit_[countHit_++] = (uint32_t)(i + iLane);
+			else if (maskGraze & (1 << iLane))
+				listGraze_[countGraze_++] = (uint32_t)(i + iLane);
+		}
+	}
+	//The tail is SSE code, and the compiler doesn't clear the upper halves before a tail call
+	_mm256_zeroupper();
+	_TestAllScalar(manager, i, x, y, radiusHit, radiusGraze);
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include "../../pch.h"
+
+#include "../Engine/MemoryPool.hpp"
+#include "../Engine/Simd.hpp"
+
+#include "ShotManager.hpp"
+#include "ShotData.hpp"
+
+//*******************************************************************
+//ShotGrid
+//	Uniform grid over the shots, rebuilt every frame by a counting sort on
+//	cell index. Shots are copied out in cell order, so the cells of one grid
+//	row are a contiguous range, and a query tests a few such ranges 4/8 at a
+//	time. Shots outside the grid fall into the border cells. Every kernel
+//	performs the same float operations, so they agree on every hit.
+//	Build costs more than testing every shot once, so a frame with a single
+//	query, like the player's, should use QueryAll instead and skip the grid.
+//*******************************************************************
+class ShotGrid {
+public:
+	//One 16-byte store per shot when scattering, transposed to lanes when testing
+	struct Entry {
+		float x, y;
+		float radius;
+		uint32_t index;		//Index in the ShotManager
+	};
+
+	//Arrays are padded to this, so kernels can read whole blocks past a range
+	static constexpr size_t LANE_COUNT = 8U;
+	static constexpr size_t MIN_CAPACITY = 1024U;
+private:
+	static constexpr uint32_t NO_CELL = 0xffffffffU;
+
+	float left_;
+	float top_;
+	float invCellSize_;
+	size_t countColumn_;
+	size_t countRow_;
+
+	std::vector<uint32_t> listCellStart_;	//Per cell first shot, then one past the last shot
+	std::vector<uint32_t> listShotCell_;	//Per shot scratch: cell, or NO_CELL if not collidable
+	float radiusMax_;
+
+	size_t count_;
+	size_t capacity_;
+	AlignedArray<Entry> listEntry_;			//Collidable shots in cell order
+
+	std::vector<float> listRadius_;			//Per graphic, for QueryAll
+
+	//Sized with the shots, so queries never allocate
+	AlignedArray<uint32_t> listHit_;
+	AlignedArray<uint32_t> listGraze_;
+	size_t countHit_;
+	size_t countGraze_;
+
+	SimdLevel kernel_;
+
+	void _Grow(size_t capacity);
+	size_t _GetColumn(float x) const;
+	size_t _GetRow(float y) const;
+
+	void _TestScalar(size_t begin, size_t end, float x, float y, float radiusHit, float radiusGraze);
+	void _TestSSE2(size_t begin, size_t end, float x, float y, float radiusHit, float radiusGraze);
+	SIMD_TARGET_AVX void _TestAVX(size_t begin, size_t end, float x, float y, float radiusHit, float radiusGraze);
+
+	void _TestAllScalar(ShotManager* manager, size_t begin, float x, float y, float radiusHit, float radiusGraze);
+	void _TestAllSSE2(ShotManager* manager, float x, float y, float radiusHit, float radiusGraze);
+	SIMD_TARGET_AVX2 void _TestAllAVX2(ShotManager* manager, float x, float y, float radiusHit, float radiusGraze);
+public:
+	ShotGrid();
+	~ShotGrid();
+
+	//The grid covers the rect, rounded up to whole cells. Defaults to ShotManager's clip rect in 32-pixel cells.
+	void SetGrid(float left, float top, float right, float bottom, float cellSize);
+	//Defaults to the best supported; higher requests fall back to what the CPU has
+	void SetKernel(SimdLevel level) { kernel_ = CpuFeature::Resolve(level); }
+	SimdLevel GetKernel() { return kernel_; }
+
+	//Deleted shots and those without a defined graphic are left out
+	void Build(ShotManager* manager, ShotDataTable* table);
+
+	//Shots whose collision circle touches the circle of radiusHit go to the hit list, the ones touching
+	//	the circle of radiusGraze but not hitting go to the graze list. Both lists are replaced.
+	void Query(float x, float y, float radiusHit, float radiusGraze);
+	//The same without the grid: every shot in the manager is tested, no Build needed, and the
+	//	lists come out in storage order. Cheaper than Build plus Query for one query a frame.
+	void QueryAll(ShotManager* manager, ShotDataTable* table, float x, float y, float radiusHit, float radiusGraze);
+
+	size_t GetCount() { return count_; }
+	size_t GetColumnCount() { return countColumn_; }
+	size_t GetRowCount() { return countRow_; }
+
+	//ShotManager indices, valid until its next Update or FlushDeleted
+	const uint32_t* GetHits() { return listHit_.GetData(); }
+	size_t GetHitCount() { return countHit_; }
+	const uint32_t* GetGrazes() { return listGraze_.GetData(); }
+	size_t GetGrazeCount() { return countGraze_; }
+};
\ No newline at end of file
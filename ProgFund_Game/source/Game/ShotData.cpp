@@ -0,0 +1,280 @@
+#include "pch.h"
+#include "ShotData.hpp"
+
+//The cache stores graphics as raw bytes, bump CACHE_VERSION when the layout changes
+static_assert(sizeof(ShotGraphic) == 36U, "ShotGraphic layout changed");
+
+//*******************************************************************
+//ShotDataTable
+//*******************************************************************
+class ShotDataParser {
+private:
+	const std::string& path_;
+	uint32_t line_;
+public:
+	std::vector<std::string> listToken;
+
+	ShotDataParser(const std::string& path) : path_(path), line_(0U) {}
+
+	//Comments start at "//"
+	void SetLine(uint32_t line, const std::string& text) {
+		line_ = line;
+		listToken.clear();
+
+		size_t end = text.find("//");
+		if (end == std::string::npos) end = text.size();
+		size_t pos = 0U;
+		while (pos < end) {
+			while (pos < end && isspace((unsigned char)text[pos])) ++pos;
+			size_t start = pos;
+			while (pos < end && !isspace((unsigned char)text[pos])) ++pos;
+			if (pos > start)
+				listToken.push_back(text.substr(start, pos - start));
+		}
+	}
+
+	[[noreturn]] void Fail(const char* message) {
+		throw EngineError(StringUtility::Format("ShotDataTable: %s(%u): %s",
+			path_.c_str(), line_, message));
+	}
+	void ExpectCount(size_t countMin, size_t countMax) {
+		if (listToken.size() < countMin || listToken.size() > countMax)
+			Fail(StringUtility::Format("Wrong number of values for \"%s\".", listToken[0].c_str()).c_str());
+	}
+
+	uint32_t GetUInt(size_t index, uint32_t max) {
+		const char* str = listToken[index].c_str();
+		char* end = nullptr;
+		unsigned long value = strtoul(str, &end, 10);
+		if (*str == '-' || *end != '\0' || end == str || value > max)
+			Fail(StringUtility::Format("\"%s\" is not an integer from 0 to %u.", str, max).c_str());
+		return (uint32_t)value;
+	}
+	float GetFloat(size_t index) {
+		const char* str = listToken[index].c_str();
+		char* end = nullptr;
+		float value = strtof(str, &end);
+		if (*end != '\0' || end == str || !std::isfinite(value))
+			Fail(StringUtility::Format("\"%s\" is not a number.", str).c_str());
+		return value;
+	}
+	BlendMode GetBlend(size_t index) {
+		static const std::pair<const char*, BlendMode> listName[] = {
+			{ "alpha", BlendMode::Alpha },
+			{ "add", BlendMode::Add },
+			{ "subtract", BlendMode::Subtract },
+			{ "rev_subtract", BlendMode::RevSubtract },
+			{ "invert", BlendMode::Invert },
+		};
+		for (auto& iName : listName) {
+			if (listToken[index] == iName.first)
+				return iName.second;
+		}
+		Fail(StringUtility::Format("Unknown blend \"%s\".", listToken[index].c_str()).c_str());
+	}
+
+	//Reads <id> <left> <top> <right> <bottom> into a zeroed graphic in the list
+	ShotGraphic* GetGraphic(std::vector<ShotGraphic>& list, const ShotDataTable::Atlas& atlas, uint32_t idMax) {
+		if (atlas.width == 0U)
+			Fail(StringUtility::Format("\"%s\" comes before its image.", listToken[0].c_str()).c_str());
+
+		uint32_t id = GetUInt(1U, idMax);
+		if (id >= list.size())
+			list.resize(id + 1U, ShotGraphic{});
+		ShotGraphic* graphic = &list[id];
+		if (graphic->IsDefined())
+			Fail(StringUtility::Format("ID %u is defined twice.", id).c_str());
+
+		uint32_t left = GetUInt(2U, atlas.width);
+		uint32_t top = GetUInt(3U, atlas.height);
+		uint32_t right = GetUInt(4U, atlas.width);
+		uint32_t bottom = GetUInt(5U, atlas.height);
+		if (right <= left || bottom <= top)
+			Fail("The rect is empty.");
+
+		graphic->u0 = left / (float)atlas.width;
+		graphic->v0 = top / (float)atlas.height;
+		graphic->u1 = right / (float)atlas.width;
+		graphic->v1 = bottom / (float)atlas.height;
+		graphic->width = (float)(right - left);
+		graphic->height = (float)(bottom - top);
+		graphic->delay = ShotDataTable::NO_DELAY;
+		graphic->flags = ShotGraphic::FLAG_DEFINED;
+		return graphic;
+	}
+};
+
+static void _WriteString(SnapshotWriter* writer, const std::string& str) {
+	writer->Write<uint32_t>((uint32_t)str.size());
+	writer->Write(str.data(), str.size());
+}
+static void _ReadString(SnapshotReader* reader, std::string& str) {
+	str.resize(reader->Read<uint32_t>());
+	reader->Read(str.data(), str.size());
+}
+
+ShotDataTable::ShotDataTable() {
+	Clear();
+}
+ShotDataTable::~ShotDataTable() {
+}
+
+void ShotDataTable::Clear() {
+	atlasShot_ = Atlas{ "", 0U, 0U };
+	atlasDelay_ = Atlas{ "", 0U, 0U };
+	listShot_.clear();
+	listDelay_.clear();
+	bCached_ = false;
+}
+
+ShotDataTable::SourceKey ShotDataTable::_GetSourceKey(const std::string& path) {
+	std::error_code error;
+	SourceKey key;
+	key.size = (uint64_t)stdfs::file_size(path, error);
+	if (!error)
+		key.time = (int64_t)stdfs::last_write_time(path, error).time_since_epoch().count();
+	if (error)
+		throw EngineError(StringUtility::Format("ShotDataTable: Failed to open %s.", path.c_str()));
+	return key;
+}
+
+void ShotDataTable::Load(const std::string& pathText, const std::string& pathCache) {
+	SourceKey key = _GetSourceKey(pathText);
+	if (_LoadCache(pathCache, key)) {
+		bCached_ = true;
+		return;
+	}
+	LoadText(pathText);
+	_SaveCache(pathCache, key);
+}
+void ShotDataTable::LoadText(const std::string& path) {
+	Clear();
+	try {
+		_ParseText(path);
+	}
+	catch (EngineError&) {
+		Clear();
+		throw;
+	}
+}
+
+void ShotDataTable::_ParseText(const std::string& path) {
+	std::ifstream stream(path, std::ios::in);
+	if (!stream.is_open())
+		throw EngineError(StringUtility::Format("ShotDataTable: Failed to open %s.", path.c_str()));
+
+	ShotDataParser parser(path);
+	std::string text;
+	uint32_t line = 0U;
+	while (std::getline(stream, text)) {
+		parser.SetLine(++line, text);
+		std::vector<std::string>& listToken = parser.listToken;
+		if (listToken.size() == 0U) continue;
+
+		const std::string& key = listToken[0];
+		if (key == "image" || key == "delay_image") {
+			parser.ExpectCount(4U, 4U);
+			Atlas& atlas = key == "image" ? atlasShot_ : atlasDelay_;
+			atlas.path = listToken[1];
+			atlas.width = parser.GetUInt(2U, 0xffffU);
+			atlas.height = parser.GetUInt(3U, 0xffffU);
+			if (atlas.width == 0U || atlas.height == 0U)
+				parser.Fail("The image size can't be zero.");
+		}
+		else if (key == "delay") {
+			//delay <id> <left> <top> <right> <bottom> <blend>
+			parser.ExpectCount(7U, 7U);
+			ShotGraphic* graphic = parser.GetGraphic(listDelay_, atlasDelay_, NO_DELAY - 1U);
+			graphic->blend = parser.GetBlend(6U);
+		}
+		else if (key == "shot") {
+			//shot <id> <left> <top> <right> <bottom> <radius> <blend> <delay> <spin> [fixed]
+			parser.ExpectCount(10U, 11U);
+			ShotGraphic* graphic = parser.GetGraphic(listShot_, atlasShot_, 0xffffU);
+			graphic->radius = parser.GetFloat(6U);
+			if (graphic->radius < 0.0f)
+				parser.Fail("The collision radius can't be negative.");
+			graphic->blend = parser.GetBlend(7U);
+			//Checked against the delay list once everything is read
+			if (listToken[8] != "-")
+				graphic->delay = (uint16_t)parser.GetUInt(8U, NO_DELAY - 1U);
+			graphic->spin = (float)Math::DegreeToRadian(parser.GetFloat(9U));
+			if (graphic->spin != 0.0f)
+				graphic->flags |= ShotGraphic::FLAG_SPIN;
+			if (listToken.size() > 10U) {
+				if (listToken[10] != "fixed")
+					parser.Fail(StringUtility::Format("Unknown flag \"%s\".", listToken[10].c_str()).c_str());
+				graphic->flags |= ShotGraphic::FLAG_FIXED_ANGLE;
+			}
+		}
+		else
+			parser.Fail(StringUtility::Format("Unknown entry \"%s\".", key.c_str()).c_str());
+	}
+
+	for (size_t i = 0; i < listShot_.size(); ++i) {
+		uint16_t delay = listShot_[i].delay;
+		if (listShot_[i].IsDefined() && delay != NO_DELAY && GetDelay(delay) == nullptr) {
+			throw EngineError(StringUtility::Format("ShotDataTable: %s: Shot %u uses undefined delay %u.",
+				path.c_str(), (uint32_t)i, (uint32_t)delay));
+		}
+	}
+}
+
+bool ShotDataTable::_LoadCache(const std::string& path, const SourceKey& key) {
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if (!stream.is_open()) return false;
+	std::vector<byte> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+	Clear();
+	try {
+		SnapshotReader reader(data);
+		if (reader.Read<uint32_t>() != CACHE_MAGIC) return false;
+		if (reader.Read<uint32_t>() != CACHE_VERSION) return false;
+		SourceKey keyCache = reader.Read<SourceKey>();
+		if (keyCache.size != key.size || keyCache.time != key.time) return false;
+
+		for (Atlas* iAtlas : { &atlasShot_, &atlasDelay_ }) {
+			_ReadString(&reader, iAtlas->path);
+			reader.Read(iAtlas->width);
+			reader.Read(iAtlas->height);
+		}
+		reader.ReadArray(listShot_);
+		reader.ReadArray(listDelay_);
+		if (!reader.IsEnd()) {
+			Clear();
+			return false;
+		}
+	}
+	catch (EngineError&) {
+		//Truncated, rebuilt from the text
+		Clear();
+		return false;
+	}
+	return true;
+}
+void ShotDataTable::_SaveCache(const std::string& path, const SourceKey& key) {
+	std::vector<byte> data;
+	data.resize(256U + (listShot_.size() + listDelay_.size()) * sizeof(ShotGraphic));
+
+	{
+		SnapshotWriter writer(&data);
+		writer.Write(CACHE_MAGIC);
+		writer.Write(CACHE_VERSION);
+		writer.Write(key);
+		for (Atlas* iAtlas : { &atlasShot_, &atlasDelay_ }) {
+			_WriteString(&writer, iAtlas->path);
+			writer.Write(iAtlas->width);
+			writer.Write(iAtlas->height);
+		}
+		writer.WriteArray(listShot_);
+		writer.WriteArray(listDelay_);
+	}
+
+	//Only costs the next launch a parse, not worth failing over
+	std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream.is_open()) {
+		printf("ShotDataTable: Failed to write cache %s\n", path.c_str());
+		return;
+	}
+	stream.write((const char*)data.data(), data.size());
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include "../../pch.h"
+
+#include "../Engine/DxConstant.hpp"
+#include "../Engine/Snapshot.hpp"
+
+//One atlas cell, shared by shot and delay graphics
+struct ShotGraphic {
+	enum : uint8_t {
+		FLAG_DEFINED = 1 << 0,		//Unused IDs below the highest one stay zeroed
+		FLAG_FIXED_ANGLE = 1 << 1,	//Drawn upright instead of facing the direction of motion
+		FLAG_SPIN = 1 << 2,			//Rotates by spin every frame, ignoring the direction of motion
+	};
+
+	float u0, v0, u1, v1;		//Normalized to the atlas size
+	float width, height;		//Pixels
+	float radius;				//Collision radius
+	float spin;					//Radians per frame
+	uint16_t delay;				//Delay graphic ID, NO_DELAY for none
+	BlendMode blend;
+	uint8_t flags;
+
+	bool IsDefined() const { return flags & FLAG_DEFINED; }
+};
+
+//*******************************************************************
+//ShotDataTable
+//	Bullet graphics of the stage atlases, indexed by the 16-bit graphic ID shots carry.
+//	The text definition is parsed once and the table saved as a binary cache,
+//	which later launches load directly for as long as the text file is unchanged.
+//*******************************************************************
+class ShotDataTable {
+public:
+	static constexpr uint32_t CACHE_MAGIC = 0x44485350U;	//"PSHD"
+	static constexpr uint32_t CACHE_VERSION = 1U;
+	static constexpr uint16_t NO_DELAY = 0xffffU;
+
+	struct Atlas {
+		std::string path;
+		uint32_t width;
+		uint32_t height;
+	};
+private:
+	//Size and modification time of the text file the cache was built from
+	struct SourceKey {
+		uint64_t size;
+		int64_t time;
+	};
+
+	Atlas atlasShot_;
+	Atlas atlasDelay_;
+	std::vector<ShotGraphic> listShot_;
+	std::vector<ShotGraphic> listDelay_;
+	bool bCached_;
+
+	static SourceKey _GetSourceKey(const std::string& path);
+
+	void _ParseText(const std::string& path);
+	//False if missing, stale or unreadable, in which case the table is left empty
+	bool _LoadCache(const std::string& path, const SourceKey& key);
+	void _SaveCache(const std::string& path, const SourceKey& key);
+public:
+	ShotDataTable();
+	~ShotDataTable();
+
+	//Paths are used as given; the cache is rewritten when it can't be used
+	void Load(const std::string& pathText, const std::string& pathCache);
+	void LoadText(const std::string& path);
+	void Clear();
+
+	//Whether the last Load was served from the cache
+	bool IsCached() { return bCached_; }
+
+	const Atlas& GetShotAtlas() { return atlasShot_; }
+	const Atlas& GetDelayAtlas() { return atlasDelay_; }
+
+	//IDs past the end read as undefined
+	const ShotGraphic* GetShot(uint16_t id) {
+		return (id < listShot_.size() && listShot_[id].IsDefined()) ? &listShot_[id] : nullptr;
+	}
+	const ShotGraphic* GetDelay(uint16_t id) {
+		return (id < listDelay_.size() && listDelay_[id].IsDefined()) ? &listDelay_[id] : nullptr;
+	}
+	//Dense arrays for batch passes; check IsDefined or the count before indexing with shot data
+	const ShotGraphic* GetShotData() { return listShot_.data(); }
+	size_t GetShotCount() { return listShot_.size(); }
+	size_t GetDelayCount() { return listDelay_.size(); }
+};
\ No newline at end of file
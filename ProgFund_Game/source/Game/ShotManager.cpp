@@ -0,0 +1,602 @@
+#include "pch.h"
+#include "ShotManager.hpp"
+#include "../Engine/Profiler.hpp"
+
+#include <bit>
+
+//Per mask of kept lanes, the lanes to gather so that the kept ones come first
+struct CompressTable {
+	uint8_t lane[256][8];
+
+	constexpr CompressTable() : lane() {
+		for (size_t iMask = 0; iMask < 256U; ++iMask) {
+			size_t iWrite = 0U;
+			for (size_t iLane = 0; iLane < 8U; ++iLane) {
+				if (iMask & (1U << iLane))
+					lane[iMask][iWrite++] = (uint8_t)iLane;
+			}
+		}
+	}
+};
+static constexpr CompressTable s_compressTable;
+
+//*******************************************************************
+//ShotManager
+//*******************************************************************
+ShotManager::ShotManager() {
+	count_ = 0U;
+	capacity_ = 0U;
+	countDeleted_ = 0U;
+	countItem_ = 0U;
+	capacityItem_ = 0U;
+	clipLeft_ = -64.0f;
+	clipTop_ = -64.0f;
+	clipRight_ = 640.0f + 64.0f;
+	clipBottom_ = 480.0f + 64.0f;
+	kernel_ = CpuFeature::GetSimdLevel();
+}
+ShotManager::~ShotManager() {
+}
+
+void ShotManager::_Grow(size_t capacity) {
+	capacity = (capacity + LANE_COUNT - 1U) & ~(LANE_COUNT - 1U);
+	listX_.Resize(capacity, count_);
+	listY_.Resize(capacity, count_);
+	listDirX_.Resize(capacity, count_);
+	listDirY_.Resize(capacity, count_);
+	listSpeed_.Resize(capacity, count_);
+	listAccel_.Resize(capacity, count_);
+	listMaxSpeed_.Resize(capacity, count_);
+	listSpinCos_.Resize(capacity, count_);
+	listSpinSin_.Resize(capacity, count_);
+	listGraphic_.Resize(capacity, count_);
+	listFlags_.Resize(capacity, count_);
+	capacity_ = capacity;
+}
+void ShotManager::Reserve(size_t count) {
+	if (count > capacity_)
+		_Grow(count);
+}
+void ShotManager::_ClearRange(size_t begin, size_t end) {
+	if (end <= begin) return;
+	size_t count = end - begin;
+	memset(&listX_[begin], 0, count * sizeof(float));
+	memset(&listY_[begin], 0, count * sizeof(float));
+	memset(&listDirX_[begin], 0, count * sizeof(float));
+	memset(&listDirY_[begin], 0, count * sizeof(float));
+	memset(&listSpeed_[begin], 0, count * sizeof(float));
+	memset(&listAccel_[begin], 0, count * sizeof(float));
+	memset(&listMaxSpeed_[begin], 0, count * sizeof(float));
+	memset(&listSpinCos_[begin], 0, count * sizeof(float));
+	memset(&listSpinSin_[begin], 0, count * sizeof(float));
+	memset(&listGraphic_[begin], 0, count * sizeof(uint16_t));
+	memset(&listFlags_[begin], 0, count * sizeof(uint16_t));
+}
+void ShotManager::Clear() {
+	_ClearRange(0U, (count_ + LANE_COUNT - 1U) & ~(LANE_COUNT - 1U));
+	count_ = 0U;
+	countDeleted_ = 0U;
+}
+
+void ShotManager::SetClipRect(float left, float top, float right, float bottom) {
+	clipLeft_ = left;
+	clipTop_ = top;
+	clipRight_ = right;
+	clipBottom_ = bottom;
+}
+
+size_t ShotManager::AddShot(const ShotParam& param) {
+	if (count_ == capacity_)
+		_Grow(std::max(capacity_ * 2U, MIN_CAPACITY));
+
+	size_t index = count_++;
+	listX_[index] = param.x;
+	listY_[index] = param.y;
+	listSpeed_[index] = param.speed;
+	listAccel_[index] = param.accel;
+	listMaxSpeed_[index] = param.maxSpeed;
+	listGraphic_[index] = param.graphic;
+	listFlags_[index] = param.flags & ~FLAG_DELETED;
+	SetAngle(index, param.angle);
+	SetAngularVelocity(index, param.angularVelocity);
+	return index;
+}
+void ShotManager::DeleteShot(size_t index) {
+	if (index >= count_ || (listFlags_[index] & FLAG_DELETED)) return;
+	listFlags_[index] |= FLAG_DELETED;
+	++countDeleted_;
+}
+void ShotManager::FlushDeleted() {
+	if (countDeleted_ == 0U) return;
+	if (countDeleted_ == count_) {
+		Clear();
+		return;
+	}
+
+	size_t countPadded = (count_ + LANE_COUNT - 1U) & ~(LANE_COUNT - 1U);
+	size_t countBlock = count_ & ~(LANE_COUNT - 1U);
+	size_t iWrite = 0U;
+	switch (kernel_) {
+	case SimdLevel::AVX2:
+		iWrite = _FlushAVX2(0U, countBlock, iWrite);
+		iWrite = _FlushScalar(countBlock, count_, iWrite);
+		break;
+	default:
+		iWrite = _FlushScalar(0U, count_, iWrite);
+		break;
+	}
+
+	_ClearRange(iWrite, countPadded);
+	count_ = iWrite;
+	countDeleted_ = 0U;
+}
+size_t ShotManager::_FlushScalar(size_t begin, size_t end, size_t iWrite) {
+	for (size_t i = begin; i < end; ++i) {
+		if (listFlags_[i] & FLAG_DELETED) continue;
+		if (iWrite != i) {
+			listX_[iWrite] = listX_[i];
+			listY_[iWrite] = listY_[i];
+			listDirX_[iWrite] = listDirX_[i];
+			listDirY_[iWrite] = listDirY_[i];
+			listSpeed_[iWrite] = listSpeed_[i];
+			listAccel_[iWrite] = listAccel_[i];
+			listMaxSpeed_[iWrite] = listMaxSpeed_[i];
+			listSpinCos_[iWrite] = listSpinCos_[i];
+			listSpinSin_[iWrite] = listSpinSin_[i];
+			listGraphic_[iWrite] = listGraphic_[i];
+			listFlags_[iWrite] = listFlags_[i];
+		}
+		++iWrite;
+	}
+	return iWrite;
+}
+//Whole blocks of 8: each array is gathered by the block's keep mask and stored unaligned at iWrite.
+//	The store can run past the kept lanes, but never past the block just read, so nothing unread is lost.
+SIMD_TARGET_AVX2 size_t ShotManager::_FlushAVX2(size_t begin, size_t end, size_t iWrite) {
+	float* listFloat[] = {
+		listX_.GetData(), listY_.GetData(), listDirX_.GetData(), listDirY_.GetData(), listSpeed_.GetData(),
+		listAccel_.GetData(), listMaxSpeed_.GetData(), listSpinCos_.GetData(), listSpinSin_.GetData(),
+	};
+	uint16_t* listShort[] = { listGraphic_.GetData(), listFlags_.GetData() };
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i deleted = _mm_set1_epi16(FLAG_DELETED);
+
+	for (size_t i = begin; i < end; i += 8U) {
+		__m128i flags = _mm_load_si128((const __m128i*)(listFlags_.GetData() + i));
+		__m128i bKeep = _mm_cmpeq_epi16(_mm_and_si128(flags, deleted), zero);
+		int maskKeep = _mm_movemask_epi8(_mm_packs_epi16(bKeep, zero));
+		if (maskKeep == 0) continue;
+
+		if (maskKeep == 0xff) {
+			if (iWrite != i) {
+				for (float* iList : listFloat)
+					_mm256_storeu_ps(iList + iWrite, _mm256_load_ps(iList + i));
+				for (uint16_t* iList : listShort)
+					_mm_storeu_si128((__m128i*)(iList + iWrite), _mm_load_si128((const __m128i*)(iList + i)));
+			}
+			iWrite += 8U;
+			continue;
+		}
+
+		__m256i lane = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)s_compressTable.lane[maskKeep]));
+		for (float* iList : listFloat)
+			_mm256_storeu_ps(iList + iWrite, _mm256_permutevar8x32_ps(_mm256_load_ps(iList + i), lane));
+		for (uint16_t* iList : listShort) {
+			__m256i value = _mm256_cvtepu16_epi32(_mm_load_si128((const __m128i*)(iList + i)));
+			value = _mm256_permutevar8x32_epi32(value, lane);
+			_mm_storeu_si128((__m128i*)(iList + iWrite),
+				_mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1)));
+		}
+		iWrite += (size_t)std::popcount((uint32_t)maskKeep);
+	}
+	return iWrite;
+}
+
+void ShotManager::_ReserveItem(size_t count) {
+	if (count <= capacityItem_) return;
+	size_t capacity = std::max(count, std::max(capacityItem_ * 2U, MIN_CAPACITY));
+	listItemX_.Resize(capacity, countItem_);
+	listItemY_.Resize(capacity, countItem_);
+	listItemGraphic_.Resize(capacity, countItem_);
+	capacityItem_ = capacity;
+}
+
+size_t ShotManager::DeleteInCircle(float x, float y, float radius, bool bToItem) {
+	return _Cancel(x, y, radius * radius, false, bToItem);
+}
+size_t ShotManager::DeleteAll(bool bToItem) {
+	return _Cancel(0.0f, 0.0f, 0.0f, true, bToItem);
+}
+size_t ShotManager::_Cancel(float x, float y, float radiusSq, bool bAll, bool bToItem) {
+	PROFILE_ZONE("ShotManager::Cancel");
+	//Room for every shot, so the kernels never grow the item list and the scalar one can store unconditionally
+	if (bToItem)
+		_ReserveItem(countItem_ + count_);
+
+	size_t countBlock = count_ & ~(LANE_COUNT - 1U);
+	size_t countCancel = 0U;
+	switch (kernel_) {
+	case SimdLevel::AVX:
+	case SimdLevel::AVX2:
+		countCancel = _CancelAVX(0U, countBlock, x, y, radiusSq, bAll, bToItem);
+		break;
+	case SimdLevel::SSE2:
+		countCancel = _CancelSSE2(0U, countBlock, x, y, radiusSq, bAll, bToItem);
+		break;
+	default:
+		countBlock = 0U;
+		break;
+	}
+	countCancel += _CancelScalar(countBlock, count_, x, y, radiusSq, bAll, bToItem);
+
+	countDeleted_ += countCancel;
+	return countCancel;
+}
+
+//Per shot, in this exact order in every kernel:
+//	cancelled if not yet deleted, and either bAll or dx * dx + dy * dy <= radiusSq,
+//	with dx = shot x - x and dy = shot y - y. Items are added in storage order.
+size_t ShotManager::_CancelScalar(size_t begin, size_t end, float x, float y, float radiusSq, bool bAll, bool bToItem) {
+	const float* px = listX_.GetData();
+	const float* py = listY_.GetData();
+	const uint16_t* pgraphic = listGraphic_.GetData();
+	uint16_t* pflags = listFlags_.GetData();
+	float* pitemX = listItemX_.GetData();
+	float* pitemY = listItemY_.GetData();
+	uint16_t* pitemGraphic = listItemGraphic_.GetData();
+
+	//Branchless, whether a shot is in the circle is close to random and a branch on it mispredicts.
+	//	Every shot is written to the next item slot, which only advances for the cancelled ones.
+	size_t countItem = countItem_;
+	size_t countCancel = 0U;
+	for (size_t i = begin; i < end; ++i) {
+		float dx = px[i] - x;
+		float dy = py[i] - y;
+		uint16_t flags = pflags[i];
+		size_t bCancel = (size_t)((bAll | (dx * dx + dy * dy <= radiusSq)) & ((flags & FLAG_DELETED) == 0));
+		pflags[i] = flags | (uint16_t)(bCancel * FLAG_DELETED);
+		if (bToItem) {
+			pitemX[countItem] = px[i];
+			pitemY[countItem] = py[i];
+			pitemGraphic[countItem] = pgraphic[i];
+			countItem += bCancel;
+		}
+		countCancel += bCancel;
+	}
+	countItem_ = countItem;
+	return countCancel;
+}
+size_t ShotManager::_CancelSSE2(size_t begin, size_t end, float x, float y, float radiusSq, bool bAll, bool bToItem) {
+	const float* px = listX_.GetData();
+	const float* py = listY_.GetData();
+	uint16_t* pflags = listFlags_.GetData();
+
+	const __m128 cx = _mm_set1_ps(x);
+	const __m128 cy = _mm_set1_ps(y);
+	const __m128 rSq = _mm_set1_ps(radiusSq);
+	const __m128 all = bAll ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : _mm_setzero_ps();
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i deleted = _mm_set1_epi16(FLAG_DELETED);
+
+	size_t countCancel = 0U;
+	for (size_t i = begin; i < end; i += 8U) {
+		__m128 bInside[2];
+		for (size_t iHalf = 0; iHalf < 2U; ++iHalf) {
+			__m128 dx = _mm_sub_ps(_mm_load_ps(px + i + iHalf * 4U), cx);
+			__m128 dy = _mm_sub_ps(_mm_load_ps(py + i + iHalf * 4U), cy);
+			__m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			bInside[iHalf] = _mm_or_ps(_mm_cmple_ps(distSq, rSq), all);
+		}
+
+		//Down to 16-bit lanes to match the flags
+		__m128i flags = _mm_load_si128((const __m128i*)(pflags + i));
+		__m128i bCancel = _mm_packs_epi32(_mm_castps_si128(bInside[0]), _mm_castps_si128(bInside[1]));
+		bCancel = _mm_and_si128(bCancel, _mm_cmpeq_epi16(_mm_and_si128(flags, deleted), zero));
+		int maskCancel = _mm_movemask_epi8(_mm_packs_epi16(bCancel, zero));
+		if (maskCancel == 0) continue;
+
+		_mm_store_si128((__m128i*)(pflags + i), _mm_or_si128(flags, _mm_and_si128(bCancel, deleted)));
+		countCancel += (size_t)std::popcount((uint32_t)maskCancel);
+		if (bToItem) {
+			//The item list has room for every live shot, so a whole block can be stored
+			if (maskCancel == 0xff) {
+				_mm_storeu_ps(&listItemX_[countItem_], _mm_load_ps(px + i));
+				_mm_storeu_ps(&listItemX_[countItem_ + 4U], _mm_load_ps(px + i + 4U));
+				_mm_storeu_ps(&listItemY_[countItem_], _mm_load_ps(py + i));
+				_mm_storeu_ps(&listItemY_[countItem_ + 4U], _mm_load_ps(py + i + 4U));
+				_mm_storeu_si128((__m128i*)&listItemGraphic_[countItem_], _mm_load_si128((const __m128i*)&listGraphic_[i]));
+				countItem_ += 8U;
+				continue;
+			}
+			for (; maskCancel != 0; maskCancel &= maskCancel - 1)
+				_AddItem(i + (size_t)std::countr_zero((uint32_t)maskCancel));
+		}
+	}
+	return countCancel;
+}
+SIMD_TARGET_AVX size_t ShotManager::_CancelAVX(size_t begin, size_t end, float x, float y, float radiusSq, bool bAll, bool bToItem) {
+	const float* px = listX_.GetData();
+	const float* py = listY_.GetData();
+	uint16_t* pflags = listFlags_.GetData();
+
+	const __m256 cx = _mm256_set1_ps(x);
+	const __m256 cy = _mm256_set1_ps(y);
+	const __m256 rSq = _mm256_set1_ps(radiusSq);
+	const __m256 all = bAll ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : _mm256_setzero_ps();
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i deleted = _mm_set1_epi16(FLAG_DELETED);
+
+	size_t countCancel = 0U;
+	for (size_t i = begin; i < end; i += 8U) {
+		__m256 dx = _mm256_sub_ps(_mm256_load_ps(px + i), cx);
+		__m256 dy = _mm256_sub_ps(_mm256_load_ps(py + i), cy);
+		__m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256 bInside = _mm256_or_ps(_mm256_cmp_ps(distSq, rSq, _CMP_LE_OQ), all);
+
+		//Down to 16-bit lanes to match the flags
+		__m128i flags = _mm_load_si128((const __m128i*)(pflags + i));
+		__m128i bCancel = _mm_packs_epi32(_mm_castps_si128(_mm256_castps256_ps128(bInside)),
+			_mm_castps_si128(_mm256_extractf128_ps(bInside, 1)));
+		bCancel = _mm_and_si128(bCancel, _mm_cmpeq_epi16(_mm_and_si128(flags, deleted), zero));
+		int maskCancel = _mm_movemask_epi8(_mm_packs_epi16(bCancel, zero));
+		if (maskCancel == 0) continue;
+
+		_mm_store_si128((__m128i*)(pflags + i), _mm_or_si128(flags, _mm_and_si128(bCancel, deleted)));
+		countCancel += (size_t)std::popcount((uint32_t)maskCancel);
+		if (bToItem) {
+			if (maskCancel == 0xff) {
+				_mm256_storeu_ps(&listItemX_[countItem_], _mm256_load_ps(px + i));
+				_mm256_storeu_ps(&listItemY_[countItem_], _mm256_load_ps(py + i));
+				_mm_storeu_si128((__m128i*)&listItemGraphic_[countItem_], _mm_load_si128((const __m128i*)&listGraphic_[i]));
+				countItem_ += 8U;
+				continue;
+			}
+			for (; maskCancel != 0; maskCancel &= maskCancel - 1)
+				_AddItem(i + (size_t)std::countr_zero((uint32_t)maskCancel));
+		}
+	}
+	return countCancel;
+}
+
+void ShotManager::SetAngle(size_t index, float angle) {
+	listDirX_[index] = (float)cos((double)angle);
+	listDirY_[index] = (float)sin((double)angle);
+}
+void ShotManager::SetAngularVelocity(size_t index, float angularVelocity) {
+	listSpinCos_[index] = (float)cos((double)angularVelocity);
+	listSpinSin_[index] = (float)sin((double)angularVelocity);
+}
+
+void ShotManager::_MarkOutside(size_t index) {
+	//Lanes past the end are padding
+	if (index >= count_) return;
+	uint16_t& flags = listFlags_[index];
+	if (flags & (FLAG_DELETED | FLAG_KEEP_OUTSIDE)) return;
+	flags |= FLAG_DELETED;
+	++countDeleted_;
+}
+
+void ShotManager::Update() {
+	PROFILE_ZONE("ShotManager::Update");
+	size_t countPadded = (count_ + LANE_COUNT - 1U) & ~(LANE_COUNT - 1U);
+	switch (kernel_) {
+	case SimdLevel::AVX:
+	case SimdLevel::AVX2:
+		_UpdateAVX(0U, countPadded);
+		break;
+	case SimdLevel::SSE2:
+		_UpdateSSE2(0U, countPadded);
+		break;
+	default:
+		_UpdateScalar(0U, countPadded);
+		break;
+	}
+	FlushDeleted();
+}
+
+//Per shot, in this exact order in every kernel:
+//	speed += accel, clamped towards maxSpeed in the direction of accel
+//	dir = rotate(dir, spin), renormalized with one Newton step
+//	pos += dir * speed
+void ShotManager::_UpdateScalar(size_t begin, size_t end) {
+	float* px = listX_.GetData();
+	float* py = listY_.GetData();
+	float* pdx = listDirX_.GetData();
+	float* pdy = listDirY_.GetData();
+	float* pspeed = listSpeed_.GetData();
+	const float* paccel = listAccel_.GetData();
+	const float* pmax = listMaxSpeed_.GetData();
+	const float* pcos = listSpinCos_.GetData();
+	const float* psin = listSpinSin_.GetData();
+
+	for (size_t i = begin; i < end; ++i) {
+		float accel = paccel[i];
+		float speed = pspeed[i] + accel;
+		float lo = speed < pmax[i] ? speed : pmax[i];
+		float hi = speed > pmax[i] ? speed : pmax[i];
+		speed = accel > 0.0f ? lo : (accel < 0.0f ? hi : speed);
+		pspeed[i] = speed;
+
+		float dx = pdx[i] * pcos[i] - pdy[i] * psin[i];
+		float dy = pdx[i] * psin[i] + pdy[i] * pcos[i];
+		float k = 1.5f - 0.5f * (dx * dx + dy * dy);
+		dx = dx * k;
+		dy = dy * k;
+		pdx[i] = dx;
+		pdy[i] = dy;
+
+		float x = px[i] + dx * speed;
+		float y = py[i] + dy * speed;
+		px[i] = x;
+		py[i] = y;
+
+		if (!(x >= clipLeft_ && x <= clipRight_ && y >= clipTop_ && y <= clipBottom_))
+			_MarkOutside(i);
+	}
+}
+void ShotManager::_UpdateSSE2(size_t begin, size_t end) {
+	float* px = listX_.GetData();
+	float* py = listY_.GetData();
+	float* pdx = listDirX_.GetData();
+	float* pdy = listDirY_.GetData();
+	float* pspeed = listSpeed_.GetData();
+	const float* paccel = listAccel_.GetData();
+	const float* pmax = listMaxSpeed_.GetData();
+	const float* pcos = listSpinCos_.GetData();
+	const float* psin = listSpinSin_.GetData();
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 threeHalves = _mm_set1_ps(1.5f);
+	const __m128 left = _mm_set1_ps(clipLeft_);
+	const __m128 top = _mm_set1_ps(clipTop_);
+	const __m128 right = _mm_set1_ps(clipRight_);
+	const __m128 bottom = _mm_set1_ps(clipBottom_);
+
+	for (size_t i = begin; i < end; i += 4U) {
+		__m128 accel = _mm_load_ps(paccel + i);
+		__m128 maxSpeed = _mm_load_ps(pmax + i);
+		__m128 speed = _mm_add_ps(_mm_load_ps(pspeed + i), accel);
+		__m128 lo = _mm_min_ps(speed, maxSpeed);
+		__m128 hi = _mm_max_ps(speed, maxSpeed);
+		__m128 bUp = _mm_cmpgt_ps(accel, zero);
+		__m128 bDown = _mm_cmplt_ps(accel, zero);
+		speed = _mm_or_ps(_mm_and_ps(bDown, hi), _mm_andnot_ps(bDown, speed));
+		speed = _mm_or_ps(_mm_and_ps(bUp, lo), _mm_andnot_ps(bUp, speed));
+		_mm_store_ps(pspeed + i, speed);
+
+		__m128 dirX = _mm_load_ps(pdx + i);
+		__m128 dirY = _mm_load_ps(pdy + i);
+		__m128 spinCos = _mm_load_ps(pcos + i);
+		__m128 spinSin = _mm_load_ps(psin + i);
+		__m128 dx = _mm_sub_ps(_mm_mul_ps(dirX, spinCos), _mm_mul_ps(dirY, spinSin));
+		__m128 dy = _mm_add_ps(_mm_mul_ps(dirX, spinSin), _mm_mul_ps(dirY, spinCos));
+		__m128 lenSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 k = _mm_sub_ps(threeHalves, _mm_mul_ps(half, lenSq));
+		dx = _mm_mul_ps(dx, k);
+		dy = _mm_mul_ps(dy, k);
+		_mm_store_ps(pdx + i, dx);
+		_mm_store_ps(pdy + i, dy);
+
+		__m128 x = _mm_add_ps(_mm_load_ps(px + i), _mm_mul_ps(dx, speed));
+		__m128 y = _mm_add_ps(_mm_load_ps(py + i), _mm_mul_ps(dy, speed));
+		_mm_store_ps(px + i, x);
+		_mm_store_ps(py + i, y);
+
+		__m128 bInside = _mm_and_ps(
+			_mm_and_ps(_mm_cmpge_ps(x, left), _mm_cmple_ps(x, right)),
+			_mm_and_ps(_mm_cmpge_ps(y, top), _mm_cmple_ps(y, bottom)));
+		int maskInside = _mm_movemask_ps(bInside);
+		if (maskInside != 0xf) {
+			for (size_t iLane = 0; iLane < 4U; ++iLane) {
+				if ((maskInside & (1 << iLane)) == 0)
+					_MarkOutside(i + iLane);
+			}
+		}
+	}
+}
+SIMD_TARGET_AVX void ShotManager::_UpdateAVX(size_t begin, size_t end) {
+	float* px = listX_.GetData();
+	float* py = listY_.GetData();
+	float* pdx = listDirX_.GetData();
+	float* pdy = listDirY_.GetData();
+	float* pspeed = listSpeed_.GetData();
+	const float* paccel = listAccel_.GetData();
+	const float* pmax = listMaxSpeed_.GetData();
+	const float* pcos = listSpinCos_.GetData();
+	const float* psin = listSpinSin_.GetData();
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 threeHalves = _mm256_set1_ps(1.5f);
+	const __m256 left = _mm256_set1_ps(clipLeft_);
+	const __m256 top = _mm256_set1_ps(clipTop_);
+	const __m256 right = _mm256_set1_ps(clipRight_);
+	const __m256 bottom = _mm256_set1_ps(clipBottom_);
+
+	for (size_t i = begin; i < end; i += 8U) {
+		__m256 accel = _mm256_load_ps(paccel + i);
+		__m256 maxSpeed = _mm256_load_ps(pmax + i);
+		__m256 speed = _mm256_add_ps(_mm256_load_ps(pspeed + i), accel);
+		__m256 lo = _mm256_min_ps(speed, maxSpeed);
+		__m256 hi = _mm256_max_ps(speed, maxSpeed);
+		//Bitwise selects rather than blendv, which GCC scalarizes here
+		__m256 bUp = _mm256_cmp_ps(accel, zero, _CMP_GT_OQ);
+		__m256 bDown = _mm256_cmp_ps(accel, zero, _CMP_LT_OQ);
+		speed = _mm256_or_ps(_mm256_and_ps(bDown, hi), _mm256_andnot_ps(bDown, speed));
+		speed = _mm256_or_ps(_mm256_and_ps(bUp, lo), _mm256_andnot_ps(bUp, speed));
+		_mm256_store_ps(pspeed + i, speed);
+
+		__m256 dirX = _mm256_load_ps(pdx + i);
+		__m256 dirY = _mm256_load_ps(pdy + i);
+		__m256 spinCos = _mm256_load_ps(pcos + i);
+		__m256 spinSin = _mm256_load_ps(psin + i);
+		__m256 dx = _mm256_sub_ps(_mm256_mul_ps(dirX, spinCos), _mm256_mul_ps(dirY, spinSin));
+		__m256 dy = _mm256_add_ps(_mm256_mul_ps(dirX, spinSin), _mm256_mul_ps(dirY, spinCos));
+		__m256 lenSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256 k = _mm256_sub_ps(threeHalves, _mm256_mul_ps(half, lenSq));
+		dx = _mm256_mul_ps(dx, k);
+		dy = _mm256_mul_ps(dy, k);
+		_mm256_store_ps(pdx + i, dx);
+		_mm256_store_ps(pdy + i, dy);
+
+		__m256 x = _mm256_add_ps(_mm256_load_ps(px + i), _mm256_mul_ps(dx, speed));
+		__m256 y = _mm256_add_ps(_mm256_load_ps(py + i), _mm256_mul_ps(dy, speed));
+		_mm256_store_ps(px + i, x);
+		_mm256_store_ps(py + i, y);
+
+		__m256 bInside = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(x, left, _CMP_GE_OQ), _mm256_cmp_ps(x, right, _CMP_LE_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(y, top, _CMP_GE_OQ), _mm256_cmp_ps(y, bottom, _CMP_LE_OQ)));
+		int maskInside = _mm256_movemask_ps(bInside);
+		if (maskInside != 0xff) {
+			for (size_t iLane = 0; iLane < 8U; ++iLane) {
+				if ((maskInside & (1 << iLane)) == 0)
+					_MarkOutside(i + iLane);
+			}
+		}
+	}
+}
+
+void ShotManager::Serialize(SnapshotWriter* writer) {
+	writer->Write<uint32_t>((uint32_t)count_);
+	writer->Write<uint32_t>((uint32_t)countDeleted_);
+	writer->Write(listX_.GetData(), count_ * sizeof(float));
+	writer->Write(listY_.GetData(), count_ * sizeof(float));
+	writer->Write(listDirX_.GetData(), count_ * sizeof(float));
+	writer->Write(listDirY_.GetData(), count_ * sizeof(float));
+	writer->Write(listSpeed_.GetData(), count_ * sizeof(float));
+	writer->Write(listAccel_.GetData(), count_ * sizeof(float));
+	writer->Write(listMaxSpeed_.GetData(), count_ * sizeof(float));
+	writer->Write(listSpinCos_.GetData(), count_ * sizeof(float));
+	writer->Write(listSpinSin_.GetData(), count_ * sizeof(float));
+	writer->Write(listGraphic_.GetData(), count_ * sizeof(uint16_t));
+	writer->Write(listFlags_.GetData(), count_ * sizeof(uint16_t));
+	float clip[4] = { clipLeft_, clipTop_, clipRight_, clipBottom_ };
+	writer->Write(clip);
+}
+void ShotManager::Restore(SnapshotReader* reader) {
+	size_t count = reader->Read<uint32_t>();
+	countDeleted_ = reader->Read<uint32_t>();
+
+	//Zero everything first, so the padding lanes match a manager that never went past count
+	count_ = 0U;
+	_Grow(std::max(std::max(capacity_, count), MIN_CAPACITY));
+	count_ = count;
+
+	reader->Read(listX_.GetData(), count_ * sizeof(float));
+	reader->Read(listY_.GetData(), count_ * sizeof(float));
+	reader->Read(listDirX_.GetData(), count_ * sizeof(float));
+	reader->Read(listDirY_.GetData(), count_ * sizeof(float));
+	reader->Read(listSpeed_.GetData(), count_ * sizeof(float));
+	reader->Read(listAccel_.GetData(), count_ * sizeof(float));
+	reader->Read(listMaxSpeed_.GetData(), count_ * sizeof(float));
+	reader->Read(listSpinCos_.GetData(), count_ * sizeof(float));
+	reader->Read(listSpinSin_.GetData(), count_ * sizeof(float));
+	reader->Read(listGraphic_.GetData(), count_ * sizeof(uint16_t));
+	reader->Read(listFlags_.GetData(), count_ * sizeof(uint16_t));
+	float clip[4];
+	reader->Read(clip);
+	SetClipRect(clip[0], clip[1], clip[2], clip[3]);
+}
\ No newline at end of file
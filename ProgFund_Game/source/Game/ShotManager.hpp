@@ -0,0 +1,151 @@
+#pragma once
+#include "../../pch.h"
+
+#include "../Engine/MemoryPool.hpp"
+#include "../Engine/Simd.hpp"
+#include "../Engine/Snapshot.hpp"
+
+//*******************************************************************
+//ShotManager
+//	All live shots as aligned structure-of-arrays, integrated 4/8 at a time.
+//	Directions are kept as unit vectors and angular velocity as a per-frame
+//	rotation, so the motion kernels need no trig. Every kernel performs the
+//	same float operations in the same order, so they agree bit for bit.
+//*******************************************************************
+class ShotManager {
+public:
+	//Arrays are padded to this, so kernels never need a scalar tail
+	static constexpr size_t LANE_COUNT = 8U;
+	static constexpr size_t MIN_CAPACITY = 1024U;
+
+	enum : uint16_t {
+		FLAG_DELETED = 1 << 0,			//Removed on the next Update or FlushDeleted
+		FLAG_KEEP_OUTSIDE = 1 << 1,		//Not deleted on leaving the clip rect
+	};
+
+	struct ShotParam {
+		float x, y;
+		float speed;
+		float angle;			//Radians
+		float accel;
+		float maxSpeed;			//Limit the speed accelerates or decelerates towards
+		float angularVelocity;	//Radians per frame
+		uint16_t graphic;		//ShotDataTable ID
+		uint16_t flags;
+	};
+private:
+	size_t count_;
+	size_t capacity_;
+	size_t countDeleted_;
+
+	AlignedArray<float> listX_;
+	AlignedArray<float> listY_;
+	AlignedArray<float> listDirX_;
+	AlignedArray<float> listDirY_;
+	AlignedArray<float> listSpeed_;
+	AlignedArray<float> listAccel_;
+	AlignedArray<float> listMaxSpeed_;
+	AlignedArray<float> listSpinCos_;
+	AlignedArray<float> listSpinSin_;
+	AlignedArray<uint16_t> listGraphic_;
+	AlignedArray<uint16_t> listFlags_;
+
+	float clipLeft_;
+	float clipTop_;
+	float clipRight_;
+	float clipBottom_;
+
+	//Shots converted to items by the batch cancels, until ClearItems
+	size_t countItem_;
+	size_t capacityItem_;
+	AlignedArray<float> listItemX_;
+	AlignedArray<float> listItemY_;
+	AlignedArray<uint16_t> listItemGraphic_;
+
+	SimdLevel kernel_;
+
+	void _Grow(size_t capacity);
+	//Padding lanes are integrated too, they're kept at zero rather than stale shots
+	void _ClearRange(size_t begin, size_t end);
+	void _MarkOutside(size_t index);
+
+	void _UpdateScalar(size_t begin, size_t end);
+	void _UpdateSSE2(size_t begin, size_t end);
+	SIMD_TARGET_AVX void _UpdateAVX(size_t begin, size_t end);
+
+	void _ReserveItem(size_t count);
+	void _AddItem(size_t index) {
+		listItemX_[countItem_] = listX_[index];
+		listItemY_[countItem_] = listY_[index];
+		listItemGraphic_[countItem_] = listGraphic_[index];
+		++countItem_;
+	}
+	size_t _Cancel(float x, float y, float radiusSq, bool bAll, bool bToItem);
+	size_t _CancelScalar(size_t begin, size_t end, float x, float y, float radiusSq, bool bAll, bool bToItem);
+	size_t _CancelSSE2(size_t begin, size_t end, float x, float y, float radiusSq, bool bAll, bool bToItem);
+	SIMD_TARGET_AVX size_t _CancelAVX(size_t begin, size_t end, float x, float y, float radiusSq, bool bAll, bool bToItem);
+
+	//Compact [begin, end) down to iWrite, returning the new end
+	size_t _FlushScalar(size_t begin, size_t end, size_t iWrite);
+	SIMD_TARGET_AVX2 size_t _FlushAVX2(size_t begin, size_t end, size_t iWrite);
+public:
+	ShotManager();
+	~ShotManager();
+
+	void Reserve(size_t count);
+	void Clear();
+
+	//Shots outside the rect are deleted at the end of Update
+	void SetClipRect(float left, float top, float right, float bottom);
+	//Defaults to the best supported; higher requests fall back to what the CPU has
+	void SetKernel(SimdLevel level) { kernel_ = CpuFeature::Resolve(level); }
+	SimdLevel GetKernel() { return kernel_; }
+
+	//Index stays valid until the next Update or FlushDeleted
+	size_t AddShot(const ShotParam& param);
+	void DeleteShot(size_t index);
+	//Stable: the remaining shots keep their order
+	void FlushDeleted();
+
+	//Batch cancels for bombs and spell card ends: one pass marks the shots like DeleteShot and returns
+	//	how many it marked. With bToItem their positions and graphics are also appended to the item list.
+	size_t DeleteInCircle(float x, float y, float radius, bool bToItem);
+	size_t DeleteAll(bool bToItem);
+
+	//Cancelled shots to spawn items for, drained within the frame: they aren't part of snapshots
+	size_t GetItemCount() { return countItem_; }
+	const float* GetItemX() { return listItemX_.GetData(); }
+	const float* GetItemY() { return listItemY_.GetData(); }
+	const uint16_t* GetItemGraphic() { return listItemGraphic_.GetData(); }
+	void ClearItems() { countItem_ = 0U; }
+
+	void Update();
+
+	size_t GetCount() { return count_; }
+	size_t GetCapacity() { return capacity_; }
+
+	const float* GetX() { return listX_.GetData(); }
+	const float* GetY() { return listY_.GetData(); }
+	const float* GetDirX() { return listDirX_.GetData(); }
+	const float* GetDirY() { return listDirY_.GetData(); }
+	const float* GetSpeed() { return listSpeed_.GetData(); }
+	const uint16_t* GetGraphic() { return listGraphic_.GetData(); }
+	const uint16_t* GetFlags() { return listFlags_.GetData(); }
+
+	float GetAngle(size_t index) { return atan2f(listDirY_[index], listDirX_[index]); }
+	void SetPosition(size_t index, float x, float y) {
+		listX_[index] = x;
+		listY_[index] = y;
+	}
+	void SetSpeed(size_t index, float speed) { listSpeed_[index] = speed; }
+	void SetAngle(size_t index, float angle);
+	void SetAcceleration(size_t index, float accel, float maxSpeed) {
+		listAccel_[index] = accel;
+		listMaxSpeed_[index] = maxSpeed;
+	}
+	void SetAngularVelocity(size_t index, float angularVelocity);
+	void SetGraphic(size_t index, uint16_t graphic) { listGraphic_[index] = graphic; }
+
+	void Serialize(SnapshotWriter* writer);
+	void Restore(SnapshotReader* reader);
+};
\ No newline at end of file
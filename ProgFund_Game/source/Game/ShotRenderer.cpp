@@ -0,0 +1,344 @@
+#include "pch.h"
+#include "ShotRenderer.hpp"
+
+#include "../Engine/Profiler.hpp"
+
+static_assert(sizeof(QuadVertex) == sizeof(VertexTLX), "QuadVertex must match VertexTLX");
+
+//*******************************************************************
+//ShotRenderer
+//*******************************************************************
+ShotRenderer::ShotRenderer() {
+	posRing_ = 0U;
+	countDraw_ = 0U;
+}
+ShotRenderer::~ShotRenderer() {
+}
+
+void ShotRenderer::Initialize() {
+	WindowMain::GetBase()->AddDxResourceListener(this);
+	SetShader(nullptr);
+}
+void ShotRenderer::Release() {
+	WindowMain::GetBase()->RemoveDxResourceListener(this);
+	listTexture_.clear();
+	shader_ = nullptr;
+}
+
+void ShotRenderer::OnLostDevice() {
+	//The dynamic buffer is recreated empty
+	posRing_ = 0U;
+}
+void ShotRenderer::OnRestoreDevice() {
+}
+
+void ShotRenderer::SetTexture(uint16_t index, shared_ptr<TextureResource> texture) {
+	if (index >= listTexture_.size())
+		listTexture_.resize(index + 1U);
+	listTexture_[index] = texture;
+}
+void ShotRenderer::SetShader(shared_ptr<ShaderResource> shader) {
+	shader_ = shader ? shader : ResourceManager::GetBase()->GetDefaultShader();
+}
+
+HRESULT ShotRenderer::_DrawChunk(const QuadVertex* vertices, size_t countQuad) {
+	IDirect3DDevice9* device = WindowMain::GetBase()->GetDevice();
+	DxVertexBuffer* buffer = VertexBufferManager::GetBase()->GetDynamicVertexBufferTLX();
+
+	//Appending never touches vertices the GPU may still be reading; wrapping around orphans the buffer instead
+	size_t countVertex = countQuad * 4U;
+	DWORD lockFlag = D3DLOCK_NOOVERWRITE;
+	if (posRing_ + countVertex > buffer->GetSize()) {
+		posRing_ = 0U;
+		lockFlag = D3DLOCK_DISCARD;
+	}
+
+	BufferLockParameter lockParam = BufferLockParameter(lockFlag);
+	lockParam.lockOffset = posRing_;
+	lockParam.data = (void*)vertices;
+	lockParam.dataCount = countVertex;
+	lockParam.dataStride = sizeof(VertexTLX);
+	HRESULT hr = buffer->UpdateBuffer(&lockParam);
+	if (FAILED(hr)) return hr;
+
+	hr = device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, posRing_, 0, countVertex, 0, countQuad * 2U);
+	posRing_ += countVertex;
+	++countDraw_;
+	return hr;
+}
+
+HRESULT ShotRenderer::Render(const ShotBatchList& list) {
+	PROFILE_ZONE("ShotRenderer::Render");
+
+	countDraw_ = 0U;
+	const std::vector<ShotBatchList::Batch>& listBatch = list.GetBatches();
+	if (listBatch.size() == 0U) return S_OK;
+
+	WindowMain* window = WindowMain::GetBase();
+	IDirect3DDevice9* device = window->GetDevice();
+	VertexBufferManager* vertexManager = VertexBufferManager::GetBase();
+
+	window->SetTextureFilter(D3DTEXF_LINEAR, D3DTEXF_LINEAR);
+
+	//Quads are built in screen space
+	D3DXMATRIX matWorld;
+	D3DXMatrixIdentity(&matWorld);
+	D3DXVECTOR4 color(1, 1, 1, 1);
+	D3DXVECTOR2 scroll(0, 0);
+
+	ID3DXEffect* effect = shader_->GetEffect();
+	{
+		D3DXHANDLE handle = nullptr;
+		if (handle = effect->GetParameterBySemantic(nullptr, "WORLD"))
+			effect->SetMatrix(handle, &matWorld);
+		if (handle = effect->GetParameterBySemantic(nullptr, "VIEWPROJECTION"))
+			effect->SetMatrix(handle, window->GetViewportMatrix());
+		if (handle = effect->GetParameterBySemantic(nullptr, "OBJCOLOR"))
+			effect->SetVector(handle, &color);
+		if (handle = effect->GetParameterBySemantic(nullptr, "UVSCROLL"))
+			effect->SetFloatArray(handle, (float*)&scroll, 2U);
+	}
+
+	shader_->SetTechnique("Render");
+
+	device->SetVertexDeclaration(vertexManager->GetDeclarationTLX());
+	device->SetStreamSource(0, vertexManager->GetDynamicVertexBufferTLX()->GetBuffer(), 0, sizeof(VertexTLX));
+	device->SetIndices(vertexManager->GetQuadIndexBuffer()->GetBuffer());
+
+	UINT countPass = 1;
+	HRESULT hr = effect->Begin(&countPass, 0);
+	if (FAILED(hr)) return hr;
+	for (UINT iPass = 0; iPass < countPass && SUCCEEDED(hr); ++iPass) {
+		effect->BeginPass(iPass);
+
+		for (const ShotBatchList::Batch& iBatch : listBatch) {
+			shared_ptr<TextureResource> texture = iBatch.texture < listTexture_.size() ?
+				listTexture_[iBatch.texture] : nullptr;
+			if (texture == nullptr)
+				texture = ResourceManager::GetBase()->GetEmptyTexture();
+			device->SetTexture(0, texture->GetTexture());
+			window->SetBlendMode(iBatch.blend);
+
+			const QuadVertex* vertices = list.GetVertices() + iBatch.index * 4U;
+			for (size_t iQuad = 0; iQuad < iBatch.count && SUCCEEDED(hr); iQuad += DX_MAX_QUAD_COUNT) {
+				size_t countChunk = std::min<size_t>(iBatch.count - iQuad, DX_MAX_QUAD_COUNT);
+				hr = _DrawChunk(vertices + iQuad * 4U, countChunk);
+			}
+			if (FAILED(hr)) break;
+		}
+
+		effect->EndPass();
+	}
+	effect->End();
+
+	device->SetVertexDeclaration(nullptr);
+
+	return hr;
+}
+
+//*******************************************************************
+//ShotInstanceRenderer
+//*******************************************************************
+const D3DVERTEXELEMENT9 ShotInstanceRenderer::VertexLayout[] = {
+	{ 0, 0, D3DDECLTYPE_FLOAT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
+	{ 1, 0, D3DDECLTYPE_FLOAT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 1 },
+	{ 1, 8, D3DDECLTYPE_SHORT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 2 },
+	{ 1, 12, D3DDECLTYPE_SHORT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 3 },
+	{ 1, 16, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR, 0 },
+	D3DDECL_END()
+};
+static_assert(sizeof(ShotInstance) == 20U, "ShotInstance must match ShotInstanceRenderer::VertexLayout");
+
+ShotInstanceRenderer::ShotInstanceRenderer() {
+	declaration_ = nullptr;
+	bufferQuad_ = nullptr;
+	bufferInstance_ = nullptr;
+	posRing_ = 0U;
+	countDraw_ = 0U;
+}
+ShotInstanceRenderer::~ShotInstanceRenderer() {
+}
+
+bool ShotInstanceRenderer::IsSupported() {
+	D3DCAPS9 caps;
+	if (FAILED(WindowMain::GetBase()->GetDevice()->GetDeviceCaps(&caps))) return false;
+	return caps.VertexShaderVersion >= D3DVS_VERSION(3, 0)
+		&& caps.PixelShaderVersion >= D3DPS_VERSION(3, 0)
+		&& (caps.DevCaps2 & D3DDEVCAPS2_STREAMOFFSET) != 0;
+}
+
+void ShotInstanceRenderer::Initialize() {
+	WindowMain* window = WindowMain::GetBase();
+	IDirect3DDevice9* device = window->GetDevice();
+
+	HRESULT hr = device->CreateVertexDeclaration(VertexLayout, &declaration_);
+	if (FAILED(hr)) {
+		throw EngineError(StringUtility::Format("ShotInstanceRenderer: Failed to create vertex declaration.\n\t%s",
+			ErrorUtility::StringFromHResult(hr).c_str()));
+	}
+
+	{
+		const float listCorner[] = {
+			0, 0,	1, 0,
+			0, 1,	1, 1,
+		};
+		bufferQuad_ = new DxVertexBuffer(device, D3DUSAGE_WRITEONLY);
+		DWORD fvf = 0U;
+		hr = bufferQuad_->Create(4U, sizeof(float) * 2U, D3DPOOL_MANAGED, &fvf);
+		if (SUCCEEDED(hr)) {
+			BufferLockParameter lockParam = BufferLockParameter(0U);
+			lockParam.data = (void*)listCorner;
+			lockParam.dataCount = 4U;
+			lockParam.dataStride = sizeof(float) * 2U;
+			hr = bufferQuad_->UpdateBuffer(&lockParam);
+		}
+		if (FAILED(hr)) {
+			throw EngineError(StringUtility::Format("ShotInstanceRenderer: Failed to create quad buffer.\n\t%s",
+				ErrorUtility::StringFromHResult(hr).c_str()));
+		}
+	}
+	_CreateInstanceBuffer();
+
+	shader_ = ResourceManager::GetBase()->LoadResource<ShaderResource>("resource/shader/shot_instanced.fx",
+		"__SHADER_SHOT_INSTANCED__");
+	shader_->SetTechniqueByName("Render");
+
+	window->AddDxResourceListener(this);
+}
+void ShotInstanceRenderer::Release() {
+	WindowMain::GetBase()->RemoveDxResourceListener(this);
+
+	ptr_release(declaration_);
+	ptr_delete(bufferQuad_);
+	ptr_delete(bufferInstance_);
+	listAtlas_.clear();
+	shader_ = nullptr;
+}
+
+void ShotInstanceRenderer::_CreateInstanceBuffer() {
+	IDirect3DDevice9* device = WindowMain::GetBase()->GetDevice();
+
+	bufferInstance_ = new DxVertexBuffer(device, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY);
+	DWORD fvf = 0U;
+	HRESULT hr = bufferInstance_->Create(INSTANCE_BUFFER_SIZE, sizeof(ShotInstance), D3DPOOL_DEFAULT, &fvf);
+	if (FAILED(hr)) {
+		throw EngineError(StringUtility::Format("ShotInstanceRenderer: Failed to create instance buffer.\n\t%s",
+			ErrorUtility::StringFromHResult(hr).c_str()));
+	}
+	posRing_ = 0U;
+}
+
+void ShotInstanceRenderer::OnLostDevice() {
+	ptr_delete(bufferInstance_);
+}
+void ShotInstanceRenderer::OnRestoreDevice() {
+	_CreateInstanceBuffer();
+}
+
+void ShotInstanceRenderer::SetAtlas(uint16_t index, shared_ptr<TextureResource> texture, ShotDataTable* table) {
+	if (index >= listAtlas_.size())
+		listAtlas_.resize(index + 1U);
+	Atlas* atlas = &listAtlas_[index];
+	atlas->texture = texture;
+
+	const ShotDataTable::Atlas& atlasData = table->GetShotAtlas();
+	atlas->size = D3DXVECTOR2((float)atlasData.width, (float)atlasData.height);
+
+	size_t count = std::min(table->GetShotCount(), ShotInstanceList::MAX_GRAPHIC);
+	const ShotGraphic* listGraphic = table->GetShotData();
+	atlas->listUVRect.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		const ShotGraphic* graphic = &listGraphic[i];
+		atlas->listUVRect[i] = D3DXVECTOR4(graphic->u0, graphic->v0, graphic->u1, graphic->v1);
+	}
+}
+
+HRESULT ShotInstanceRenderer::_DrawChunk(const ShotInstance* instances, size_t count) {
+	IDirect3DDevice9* device = WindowMain::GetBase()->GetDevice();
+
+	DWORD lockFlag = D3DLOCK_NOOVERWRITE;
+	if (posRing_ + count > bufferInstance_->GetSize()) {
+		posRing_ = 0U;
+		lockFlag = D3DLOCK_DISCARD;
+	}
+
+	BufferLockParameter lockParam = BufferLockParameter(lockFlag);
+	lockParam.lockOffset = posRing_;
+	lockParam.data = (void*)instances;
+	lockParam.dataCount = count;
+	lockParam.dataStride = sizeof(ShotInstance);
+	HRESULT hr = bufferInstance_->UpdateBuffer(&lockParam);
+	if (FAILED(hr)) return hr;
+
+	device->SetStreamSourceFreq(0, D3DSTREAMSOURCE_INDEXEDDATA | (UINT)count);
+	device->SetStreamSource(1, bufferInstance_->GetBuffer(), posRing_ * sizeof(ShotInstance), sizeof(ShotInstance));
+	hr = device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, 4U, 0, 2U);
+	posRing_ += count;
+	++countDraw_;
+	return hr;
+}
+
+HRESULT ShotInstanceRenderer::Render(const ShotInstanceList& list) {
+	PROFILE_ZONE("ShotInstanceRenderer::Render");
+
+	countDraw_ = 0U;
+	const std::vector<ShotInstanceList::Batch>& listBatch = list.GetBatches();
+	if (listBatch.size() == 0U || bufferInstance_ == nullptr) return S_OK;
+
+	WindowMain* window = WindowMain::GetBase();
+	IDirect3DDevice9* device = window->GetDevice();
+
+	window->SetTextureFilter(D3DTEXF_LINEAR, D3DTEXF_LINEAR);
+
+	ID3DXEffect* effect = shader_->GetEffect();
+	D3DXHANDLE handleAtlasSize = effect->GetParameterBySemantic(nullptr, "ATLASSIZE");
+	D3DXHANDLE handleUVRect = effect->GetParameterBySemantic(nullptr, "UVRECT");
+	if (D3DXHANDLE handle = effect->GetParameterBySemantic(nullptr, "VIEWPROJECTION"))
+		effect->SetMatrix(handle, window->GetViewportMatrix());
+
+	shader_->SetTechnique("Render");
+
+	device->SetVertexDeclaration(declaration_);
+	device->SetStreamSource(0, bufferQuad_->GetBuffer(), 0, sizeof(float) * 2U);
+	device->SetStreamSourceFreq(1, D3DSTREAMSOURCE_INSTANCEDATA | 1U);
+	device->SetIndices(VertexBufferManager::GetBase()->GetQuadIndexBuffer()->GetBuffer());
+
+	UINT countPass = 1;
+	HRESULT hr = effect->Begin(&countPass, 0);
+	if (SUCCEEDED(hr)) {
+		for (UINT iPass = 0; iPass < countPass && SUCCEEDED(hr); ++iPass) {
+			effect->BeginPass(iPass);
+
+			for (const ShotInstanceList::Batch& iBatch : listBatch) {
+				Atlas* atlas = iBatch.texture < listAtlas_.size() ? &listAtlas_[iBatch.texture] : nullptr;
+				if (atlas == nullptr || atlas->texture == nullptr || atlas->listUVRect.size() == 0U) continue;
+
+				device->SetTexture(0, atlas->texture->GetTexture());
+				window->SetBlendMode(iBatch.blend);
+				if (handleAtlasSize)
+					effect->SetFloatArray(handleAtlasSize, (float*)&atlas->size, 2U);
+				if (handleUVRect)
+					effect->SetVectorArray(handleUVRect, atlas->listUVRect.data(), atlas->listUVRect.size());
+				effect->CommitChanges();
+
+				const ShotInstance* instances = list.GetInstances() + iBatch.index;
+				for (size_t iInstance = 0; iInstance < iBatch.count && SUCCEEDED(hr); iInstance += INSTANCE_BUFFER_SIZE) {
+					size_t countChunk = std::min<size_t>(iBatch.count - iInstance, INSTANCE_BUFFER_SIZE);
+					hr = _DrawChunk(instances + iInstance, countChunk);
+				}
+				if (FAILED(hr)) break;
+			}
+
+			effect->EndPass();
+		}
+		effect->End();
+	}
+
+	//Leaves the streams as non-instanced draws expect them
+	device->SetStreamSourceFreq(0, 1U);
+	device->SetStreamSourceFreq(1, 1U);
+	device->SetStreamSource(1, nullptr, 0, 0);
+	device->SetVertexDeclaration(nullptr);
+
+	return hr;
+}
\ No newline at end of file
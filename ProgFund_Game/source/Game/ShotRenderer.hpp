@@ -0,0 +1,128 @@
+#pragma once
+#include "../../pch.h"
+
+#include "../Engine/Object.hpp"
+
+#include "ShotBatch.hpp"
+
+//*******************************************************************
+//ShotRenderer
+//	Draws ShotBatchLists through VertexBufferManager's dynamic TLX buffer,
+//	used as a ring: each chunk is appended with NOOVERWRITE, and the buffer
+//	is DISCARDed and restarted when a chunk doesn't fit in what's left.
+//	Indices come from the shared quad index buffer, so a batch is a single
+//	draw unless it exceeds DX_MAX_QUAD_COUNT quads.
+//*******************************************************************
+class ShotRenderer : public DxResourceManagerBase {
+private:
+	std::vector<shared_ptr<TextureResource>> listTexture_;	//By batch texture index
+	shared_ptr<ShaderResource> shader_;
+
+	size_t posRing_;	//First free vertex in the dynamic buffer
+	size_t countDraw_;
+
+	HRESULT _DrawChunk(const QuadVertex* vertices, size_t countQuad);
+public:
+	ShotRenderer();
+	virtual ~ShotRenderer();
+
+	void Initialize();
+	void Release();
+
+	virtual void OnLostDevice();
+	virtual void OnRestoreDevice();
+
+	void SetTexture(uint16_t index, shared_ptr<TextureResource> texture);
+	void SetShader(shared_ptr<ShaderResource> shader);
+
+	HRESULT Render(const ShotBatchList& list);
+
+	//Draw calls issued by the last Render
+	size_t GetDrawCount() { return countDraw_; }
+};
+
+//*******************************************************************
+//ShotRenderObject
+//	Hands a ShotBatchList to a RenderFrame. The frame is drawn while the next
+//	one is simulated, so keep two of these and build into them alternately.
+//*******************************************************************
+class ShotRenderObject : public RenderObject {
+private:
+	ShotRenderer* renderer_;
+	ShotBatchList list_;
+public:
+	ShotRenderObject(ShotRenderer* renderer) : renderer_(renderer) {}
+
+	virtual void Update() {}
+	virtual HRESULT Render() { return renderer_->Render(list_); }
+	virtual HRESULT Render(const RenderState& state) { return Render(); }
+
+	ShotBatchList* GetBatchList() { return &list_; }
+};
+
+//*******************************************************************
+//ShotInstanceRenderer
+//	Draws ShotInstanceLists with hardware instancing: a static unit quad in
+//	stream 0, the instances in stream 1, expanded by shot_instanced.fx. Moves
+//	a fifth of the bytes the quad path does and builds no vertices on the CPU.
+//	Instances go through a dynamic buffer used as a ring like ShotRenderer's.
+//	Needs vs_3_0 and stream offsets; check IsSupported and fall back to ShotRenderer.
+//*******************************************************************
+class ShotInstanceRenderer : public DxResourceManagerBase {
+public:
+	static constexpr size_t INSTANCE_BUFFER_SIZE = DX_MAX_BUFFER_SIZE;
+private:
+	struct Atlas {
+		shared_ptr<TextureResource> texture;
+		D3DXVECTOR2 size;
+		std::vector<D3DXVECTOR4> listUVRect;
+	};
+
+	static const D3DVERTEXELEMENT9 VertexLayout[];
+
+	std::vector<Atlas> listAtlas_;	//By batch texture index
+	shared_ptr<ShaderResource> shader_;
+
+	IDirect3DVertexDeclaration9* declaration_;
+	DxVertexBuffer* bufferQuad_;		//Managed, kept through device resets
+	DxVertexBuffer* bufferInstance_;
+
+	size_t posRing_;	//First free instance in the instance buffer
+	size_t countDraw_;
+
+	void _CreateInstanceBuffer();
+	HRESULT _DrawChunk(const ShotInstance* instances, size_t count);
+public:
+	ShotInstanceRenderer();
+	virtual ~ShotInstanceRenderer();
+
+	static bool IsSupported();
+
+	void Initialize();
+	void Release();
+
+	virtual void OnLostDevice();
+	virtual void OnRestoreDevice();
+
+	//The UV rect table is copied from the shot data, up to ShotInstanceList::MAX_GRAPHIC entries
+	void SetAtlas(uint16_t index, shared_ptr<TextureResource> texture, ShotDataTable* table);
+
+	HRESULT Render(const ShotInstanceList& list);
+
+	size_t GetDrawCount() { return countDraw_; }
+};
+
+//ShotRenderObject for the instanced path
+class ShotInstanceRenderObject : public RenderObject {
+private:
+	ShotInstanceRenderer* renderer_;
+	ShotInstanceList list_;
+public:
+	ShotInstanceRenderObject(ShotInstanceRenderer* renderer) : renderer_(renderer) {}
+
+	virtual void Update() {}
+	virtual HRESULT Render() { return renderer_->Render(list_); }
+	virtual HRESULT Render(const RenderState& state) { return Render(); }
+
+	ShotInstanceList* GetInstanceList() { return &list_; }
+};
\ No newline at end of file